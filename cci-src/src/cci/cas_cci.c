@@ -132,10 +132,30 @@ int wsa_initialize ();
 #define CCI_DS_DEFAULT_ISOLATION_DEFAULT                TRAN_UNKNOWN_ISOLATION
 #define CCI_DS_DEFAULT_LOCK_TIMEOUT_DEFAULT             CCI_LOCK_TIMEOUT_DEFAULT
 #define CCI_DS_LOGIN_TIMEOUT_DEFAULT			-1
+#define CCI_DS_IDLE_TIMEOUT_DEFAULT			0
+#define CCI_DS_WARM_THREADS_MAX				4
 
 #define CON_HANDLE_ID_FACTOR            1000000
 #define CON_ID(a) ((a) / CON_HANDLE_ID_FACTOR)
 #define REQ_ID(a) ((a) % CON_HANDLE_ID_FACTOR)
+
+/************************************************************************
+ * PRIVATE TYPE DEFINITIONS                                             *
+ ************************************************************************/
+
+/*
+ * A borrower queued in cci_datasource_borrow.  Waiters are served in
+ * arrival order: a released connection is handed to the head of the
+ * queue directly, so a newly arriving borrower cannot take it first.
+ */
+typedef struct t_datasource_waiter T_DATASOURCE_WAITER;
+struct t_datasource_waiter
+{
+  pthread_cond_t cond;
+  int slot;			/* granted con_handles index, -1 while waiting */
+  T_DATASOURCE_WAITER *prev;
+  T_DATASOURCE_WAITER *next;
+};
 /************************************************************************
  * PRIVATE FUNCTION PROTOTYPES                                          *
  ************************************************************************/
@@ -188,6 +208,15 @@ static void copy_error_buffer (T_CCI_ERROR * dest_err_buf_p,
 			       T_CCI_ERROR * src_err_buf_p);
 static int cci_datasource_release_internal (T_CCI_DATASOURCE * ds,
 					    T_CON_HANDLE * con_handle);
+static int cci_datasource_pop_idle (T_CCI_DATASOURCE * ds);
+static T_CCI_CONN cci_datasource_connect (T_CCI_DATASOURCE * ds, int slot);
+static void cci_datasource_put_slot (T_CCI_DATASOURCE * ds, int slot);
+static T_CCI_CONN cci_datasource_shrink (T_CCI_DATASOURCE * ds);
+static THREAD_RET_T THREAD_CALLING_CONVENTION
+cci_datasource_warm_thread (void *arg);
+static void cci_datasource_grant_waiters (T_CCI_DATASOURCE * ds);
+static int cci_datasource_wait (T_CCI_DATASOURCE * ds,
+				T_CCI_ERROR * err_buf);
 static int cci_end_tran_internal (T_CON_HANDLE * con_handle, char type);
 static void get_last_error (T_CON_HANDLE * con_handle,
 			    T_CCI_ERROR * dest_err_buf);
@@ -237,7 +266,8 @@ static const char *datasource_key[] = {
   CCI_DS_PROPERTY_DEFAULT_AUTOCOMMIT,
   CCI_DS_PROPERTY_DEFAULT_ISOLATION,
   CCI_DS_PROPERTY_DEFAULT_LOCK_TIMEOUT,
-  CCI_DS_PROPERTY_MAX_POOL_SIZE
+  CCI_DS_PROPERTY_MAX_POOL_SIZE,
+  CCI_DS_PROPERTY_IDLE_TIMEOUT
 };
 
 CCI_MALLOC_FUNCTION cci_malloc = malloc;
@@ -306,6 +336,7 @@ cci_init ()
 #if defined(WINDOWS)
       MUTEX_INIT (con_handle_table_mutex);
 #endif
+      cci_url_cache_init ();
     }
 }
 
@@ -457,11 +488,11 @@ static int
 cci_connect_with_url_internal (char *url, char *user, char *pass,
 			       T_CCI_ERROR * err_buf)
 {
-  char *token[MAX_URL_MATCH_COUNT] = { NULL };
+  T_URL_ENTRY *url_entry = NULL;
   int error = CCI_ER_NO_ERROR;
-  unsigned i;
 
   char *property = NULL;
+  char *property_buf = NULL;
   char *end = NULL;
   char *host, *dbname;
   int port;
@@ -500,31 +531,42 @@ cci_connect_with_url_internal (char *url, char *user, char *pass,
       pass = (char *) "";
     }
 
-  error = cci_url_match (url, token);
+  error = cci_url_parse (url, &url_entry);
   if (error != CCI_ER_NO_ERROR)
     {
       set_error_buffer (err_buf, error, NULL);
       return error;
     }
 
-  host = token[0];
-  port = (int) strtol (token[1], &end, 10);
-  dbname = token[2];
+  host = url_entry->token[0];
+  port = (int) strtol (url_entry->token[1], &end, 10);
+  dbname = url_entry->token[2];
 
   if (*user == '\0')
     {
-      user = token[3];
+      user = url_entry->token[3];
     }
   if (*pass == '\0')
     {
-      pass = token[4];
+      pass = url_entry->token[4];
     }
 
-  property = token[5];
-  if (property == NULL)
+  /* the cached tokens are shared; the properties are split in place */
+  if (url_entry->token[5] == NULL)
     {
       property = (char *) "";
     }
+  else
+    {
+      ALLOC_COPY (property_buf, url_entry->token[5]);
+      if (property_buf == NULL)
+	{
+	  cci_url_release (url_entry);
+	  set_error_buffer (err_buf, CCI_ER_NO_MORE_MEMORY, NULL);
+	  return CCI_ER_NO_MORE_MEMORY;
+	}
+      property = property_buf;
+    }
 
   if (user[0] == '\0')
     {
@@ -544,10 +586,8 @@ cci_connect_with_url_internal (char *url, char *user, char *pass,
   con_handle = get_new_connection (host, port, dbname, user, pass);
   if (con_handle == NULL)
     {
-      for (i = 0; i < MAX_URL_MATCH_COUNT; i++)
-	{
-	  FREE_MEM (token[i]);
-	}
+      FREE_MEM (property_buf);
+      cci_url_release (url_entry);
 
       set_error_buffer (err_buf, CCI_ER_CON_HANDLE, NULL);
 
@@ -603,10 +643,8 @@ cci_connect_with_url_internal (char *url, char *user, char *pass,
   RESET_START_TIME (con_handle);
 
 ret:
-  for (i = 0; i < MAX_URL_MATCH_COUNT; i++)
-    {
-      FREE_MEM (token[i]);
-    }
+  FREE_MEM (property_buf);
+  cci_url_release (url_entry);
 
 #ifdef CCI_DEBUG
   CCI_DEBUG_PRINT (print_debug_msg
@@ -710,8 +748,8 @@ cci_disconnect (int mapped_conn_id, T_CCI_ERROR * err_buf)
 
   if (con_handle->datasource)
     {
-      con_handle->used = false;
       hm_release_connection (mapped_conn_id, &con_handle);
+      con_handle->used = false;
 
       if (cci_end_tran_internal (con_handle, CCI_TRAN_ROLLBACK) != NO_ERROR)
 	{
@@ -729,15 +767,28 @@ cci_disconnect (int mapped_conn_id, T_CCI_ERROR * err_buf)
 
       get_last_error (con_handle, err_buf);
     }
-  else if (con_handle->broker_info[BROKER_INFO_CCI_PCONNECT]
-	   && hm_put_con_to_pool (con_handle->id) >= 0)
+  else if (con_handle->broker_info[BROKER_INFO_CCI_PCONNECT])
     {
-      cci_end_tran_internal (con_handle, CCI_TRAN_ROLLBACK);
+      bool can_pool;
+
+      /* the handle may be taken from the pool by another thread at once,
+       * so it is settled and unmapped first */
+      can_pool = (cci_end_tran_internal (con_handle, CCI_TRAN_ROLLBACK)
+		  == NO_ERROR);
       API_ELOG (con_handle, 0);
 
       get_last_error (con_handle, err_buf);
-      con_handle->used = false;
       hm_release_connection (mapped_conn_id, &con_handle);
+      con_handle->used = false;
+
+      if (!can_pool || hm_put_con_to_pool (con_handle->id) < 0)
+	{
+	  error = qe_con_close (con_handle);
+
+	  MUTEX_LOCK (con_handle_table_mutex);
+	  hm_con_handle_free (con_handle);
+	  MUTEX_UNLOCK (con_handle_table_mutex);
+	}
     }
   else
     {
@@ -746,8 +797,8 @@ cci_disconnect (int mapped_conn_id, T_CCI_ERROR * err_buf)
 
       set_error_buffer (&(con_handle->err_buf), error, NULL);
       get_last_error (con_handle, err_buf);
-      con_handle->used = false;
 
+      /* still claimed, so no lookup can race with the free */
       MUTEX_LOCK (con_handle_table_mutex);
       hm_delete_connection (mapped_conn_id, &con_handle);
       MUTEX_UNLOCK (con_handle_table_mutex);
@@ -928,6 +979,10 @@ cci_prepare (int mapped_conn_id, char *sql_stmt, char flag,
       if (statement_id != CCI_ER_REQ_HANDLE)
 	{
 	  req_handle->query_timeout = con_handle->query_timeout;
+	  /* fetch options of the previous user do not carry over */
+	  req_handle->fetch_size = REQ_HANDLE_FETCH_SIZE_DEFAULT;
+	  req_handle->fetch_size_budget = 0;
+	  req_handle->read_ahead = 0;
 	  goto prepare_end;
 	}
     }
@@ -1186,6 +1241,20 @@ cci_get_result_info (int mapped_stmt_id, T_CCI_CUBRID_STMT * cmd_type,
 int
 cci_bind_param (int mapped_stmt_id, int index, T_CCI_A_TYPE a_type,
 		void *value, T_CCI_U_TYPE u_type, char flag)
+{
+  return cci_bind_param_ex (mapped_stmt_id, index, a_type, value, -1,
+			    u_type, flag);
+}
+
+/*
+ * cci_bind_param_ex - cci_bind_param with the byte length of a string
+ *   value (CCI_A_TYPE_STR bound to a character type). The value may hold
+ *   NUL bytes and need not be NUL terminated. A length of -1 means
+ *   strlen (value).
+ */
+int
+cci_bind_param_ex (int mapped_stmt_id, int index, T_CCI_A_TYPE a_type,
+		   void *value, int length, T_CCI_U_TYPE u_type, char flag)
 {
   int error;
   T_CON_HANDLE *con_handle = NULL;
@@ -1193,10 +1262,10 @@ cci_bind_param (int mapped_stmt_id, int index, T_CCI_A_TYPE a_type,
 
 #ifdef CCI_FULL_DEBUG
   CCI_DEBUG_PRINT (print_debug_msg
-		   ("(%d:%d)cci_bind_param: %d %s %p %s %d",
+		   ("(%d:%d)cci_bind_param_ex: %d %s %p %d %s %d",
 		    CON_ID (mapped_stmt_id), REQ_ID (mapped_stmt_id), index,
-		    dbg_a_type_str (a_type), value, dbg_u_type_str (u_type),
-		    flag));
+		    dbg_a_type_str (a_type), value, length,
+		    dbg_u_type_str (u_type), flag));
 #endif
 
   error = hm_get_statement (mapped_stmt_id, &con_handle, &req_handle);
@@ -1205,7 +1274,8 @@ cci_bind_param (int mapped_stmt_id, int index, T_CCI_A_TYPE a_type,
       return error;
     }
 
-  error = qe_bind_param (req_handle, index, a_type, value, u_type, flag);
+  error =
+    qe_bind_param (req_handle, index, a_type, value, length, u_type, flag);
 
   con_handle->used = false;
 
@@ -1309,6 +1379,10 @@ cci_bind_param_array (int mapped_stmt_id, int index, T_CCI_A_TYPE a_type,
   else
     {
       index--;
+      if (req_handle->bind_value[index].flag == BIND_PTR_DYNAMIC)
+	{
+	  FREE_MEM (req_handle->bind_value[index].value);
+	}
       req_handle->bind_value[index].u_type = u_type;
       req_handle->bind_value[index].size = a_type;
       req_handle->bind_value[index].value = value;
@@ -2279,15 +2353,21 @@ cci_close_req_handle (int mapped_stmt_id)
 
   API_SLOG (con_handle);
 
-  if (DOES_CONNECTION_HAVE_STMT_POOL (con_handle))
+  /* without a datasource, an open autocommit transaction is only ended by
+   * the server when the statement is really closed, so it is not pooled */
+  if (DOES_CONNECTION_HAVE_STMT_POOL (con_handle)
+      && (con_handle->datasource != NULL
+	  || con_handle->autocommit_mode != CCI_AUTOCOMMIT_TRUE
+	  || con_handle->con_status != CCI_CON_STATUS_IN_TRAN))
     {
       qe_close_query_result (req_handle, con_handle);
 
       /* free req_handle resources */
       req_handle_content_free_for_pool (req_handle);
 
-      if (con_handle->autocommit_mode == CCI_AUTOCOMMIT_TRUE &&
-	  con_handle->con_status != CCI_CON_STATUS_OUT_TRAN)
+      if (con_handle->datasource != NULL
+	  && con_handle->autocommit_mode == CCI_AUTOCOMMIT_TRUE
+	  && con_handle->con_status != CCI_CON_STATUS_OUT_TRAN)
 	{
 	  T_CCI_ERROR err_buf;
 	  qe_end_tran (con_handle, CCI_TRAN_ROLLBACK, &err_buf);
@@ -2385,6 +2465,56 @@ cci_fetch_size (int mapped_stmt_id, int fetch_size)
   return error;
 }
 
+int
+cci_fetch_size_adaptive (int mapped_stmt_id, int max_bytes)
+{
+  T_CON_HANDLE *con_handle = NULL;
+  T_REQ_HANDLE *req_handle = NULL;
+  int error;
+
+#ifdef CCI_FULL_DEBUG
+  CCI_DEBUG_PRINT (print_debug_msg ("(%d:%d)cci_fetch_size_adaptive: %d",
+				    CON_ID (mapped_stmt_id),
+				    REQ_ID (mapped_stmt_id), max_bytes));
+#endif
+
+  error = hm_get_statement (mapped_stmt_id, &con_handle, &req_handle);
+  if (error != CCI_ER_NO_ERROR)
+    {
+      return error;
+    }
+
+  req_handle->fetch_size_budget = (max_bytes > 0) ? max_bytes : 0;
+  con_handle->used = false;
+
+  return error;
+}
+
+int
+cci_fetch_read_ahead (int mapped_stmt_id, int flag)
+{
+  T_CON_HANDLE *con_handle = NULL;
+  T_REQ_HANDLE *req_handle = NULL;
+  int error;
+
+#ifdef CCI_FULL_DEBUG
+  CCI_DEBUG_PRINT (print_debug_msg ("(%d:%d)cci_fetch_read_ahead: %d",
+				    CON_ID (mapped_stmt_id),
+				    REQ_ID (mapped_stmt_id), flag));
+#endif
+
+  error = hm_get_statement (mapped_stmt_id, &con_handle, &req_handle);
+  if (error != CCI_ER_NO_ERROR)
+    {
+      return error;
+    }
+
+  req_handle->read_ahead = (flag) ? 1 : 0;
+  con_handle->used = false;
+
+  return error;
+}
+
 int
 cci_fetch (int mapped_stmt_id, T_CCI_ERROR * err_buf)
 {
@@ -2446,6 +2576,114 @@ cci_get_data (int mapped_stmt_id, int col_no, int a_type, void *value,
   return error;
 }
 
+/*
+ * Read up to max_rows rows (all when max_rows <= 0) from the cursor
+ * position on, as cci_cursor, cci_fetch and cci_get_data would, and give
+ * every value to value_fn as soon as it is read. Column i is read as
+ * a_types[i - 1]. The rows of a fetched block are read straight from the
+ * block, and the cursor is left after the last row read. value_fn must not
+ * call CCI functions on the same connection. Returns the number of rows.
+ */
+int
+cci_fetch_rows (int mapped_stmt_id, int max_rows, int num_cols,
+		const int *a_types, CCI_FETCH_VALUE_FUNCTION value_fn,
+		void *arg, T_CCI_ERROR * err_buf)
+{
+  T_REQ_HANDLE *req_handle = NULL;
+  T_CON_HANDLE *con_handle = NULL;
+  int error = CCI_ER_NO_ERROR;
+  int rows = 0;
+  int i, indicator;
+  union
+  {
+    int i;
+    INT64 bi;
+    float f;
+    double d;
+    char *str;
+    T_CCI_DATE date;
+    T_CCI_BIT bit;
+    void *ptr;
+  } value;
+
+#ifdef CCI_FULL_DEBUG
+  CCI_DEBUG_PRINT (print_debug_msg
+		   ("(%d:%d)cci_fetch_rows: %d", CON_ID (mapped_stmt_id),
+		    REQ_ID (mapped_stmt_id), max_rows));
+#endif
+
+  reset_error_buffer (err_buf);
+  if (a_types == NULL || value_fn == NULL)
+    {
+      set_error_buffer (err_buf, CCI_ER_INVALID_ARGS, NULL);
+      return CCI_ER_INVALID_ARGS;
+    }
+
+  error = hm_get_statement (mapped_stmt_id, &con_handle, &req_handle);
+  if (error != CCI_ER_NO_ERROR)
+    {
+      set_error_buffer (err_buf, error, NULL);
+      return error;
+    }
+  reset_error_buffer (&(con_handle->err_buf));
+
+  while (max_rows <= 0 || rows < max_rows)
+    {
+      error = qe_cursor (req_handle, con_handle, 0, CCI_CURSOR_CURRENT,
+			 &(con_handle->err_buf));
+      if (error == CCI_ER_NO_MORE_DATA)
+	{
+	  error = CCI_ER_NO_ERROR;
+	  break;
+	}
+      if (error < 0)
+	{
+	  break;
+	}
+
+      error = qe_fetch (req_handle, con_handle, 0, 0, &(con_handle->err_buf));
+      if (error < 0)
+	{
+	  break;
+	}
+
+      /* the rest of the fetched block needs no cursor or fetch request */
+      do
+	{
+	  req_handle->cur_fetch_tuple_index =
+	    req_handle->cursor_pos - req_handle->fetched_tuple_begin;
+	  for (i = 0; i < num_cols; i++)
+	    {
+	      error = qe_get_data (con_handle, req_handle, i + 1, a_types[i],
+				   &value, &indicator);
+	      if (error < 0)
+		{
+		  goto fetch_rows_end;
+		}
+	      value_fn (arg, i + 1, &value, indicator);
+	    }
+	  rows++;
+	  req_handle->cursor_pos++;
+	}
+      while ((max_rows <= 0 || rows < max_rows)
+	     && req_handle->cursor_pos <= req_handle->fetched_tuple_end
+	     && (req_handle->num_tuple < 0
+		 || req_handle->cursor_pos <= req_handle->num_tuple));
+    }
+
+fetch_rows_end:
+  if (IS_OUT_TRAN (con_handle))
+    {
+      hm_check_rc_time (con_handle);
+    }
+
+  set_error_buffer (&(con_handle->err_buf), error, NULL);
+  get_last_error (con_handle, err_buf);
+  con_handle->used = false;
+
+  return (error < 0) ? error : rows;
+}
+
 static int
 cci_schema_info_internal (int mapped_conn_id, T_CCI_SCH_TYPE type, char *arg1,
 			  char *arg2, char flag, int shard_id,
@@ -2824,6 +3062,79 @@ cci_set_holdability (int mapped_conn_id, int holdable)
   return error;
 }
 
+/*
+ * Keep up to max_size closed statements of the connection prepared on the
+ * server, keyed by SQL text, so that preparing the same text again needs
+ * no round trip. 0 turns the pool off. Connections borrowed from a
+ * datasource use the datasource settings instead.
+ */
+int
+cci_set_statement_pool_size (int mapped_conn_id, int max_size)
+{
+  T_CON_HANDLE *con_handle = NULL;
+  int error = 0;
+
+  if (max_size < 0)
+    {
+      return CCI_ER_INVALID_ARGS;
+    }
+
+#ifdef CCI_DEBUG
+  CCI_DEBUG_PRINT (print_debug_msg
+		   ("cci_set_statement_pool_size %d", max_size));
+#endif
+
+  error = hm_get_connection (mapped_conn_id, &con_handle);
+  if (error != CCI_ER_NO_ERROR)
+    {
+      return error;
+    }
+  reset_error_buffer (&(con_handle->err_buf));
+
+  if (con_handle->datasource != NULL)
+    {
+      error = CCI_ER_INVALID_ARGS;
+    }
+  else
+    {
+      error = hm_pool_set_max_size (con_handle, max_size);
+    }
+  con_handle->used = false;
+
+  return error;
+}
+
+/*
+ * Limits for connections kept after cci_disconnect when the broker has
+ * CCI_PCONNECT on: at most max_idle_per_key idle connections per
+ * (host, port, db, user, password), closed after idle_timeout seconds
+ * (0 keeps them until they are reused).
+ */
+int
+cci_set_con_pool_limits (int max_idle_per_key, int idle_timeout)
+{
+#ifdef CCI_DEBUG
+  CCI_DEBUG_PRINT (print_debug_msg
+		   ("cci_set_con_pool_limits %d %d", max_idle_per_key,
+		    idle_timeout));
+#endif
+
+  return hm_con_pool_set_limits (max_idle_per_key, idle_timeout);
+}
+
+int
+cci_get_con_pool_stats (T_CCI_CON_POOL_STATS * stats)
+{
+  if (stats == NULL)
+    {
+      return CCI_ER_INVALID_ARGS;
+    }
+
+  hm_con_pool_get_stats (stats);
+
+  return CCI_ER_NO_ERROR;
+}
+
 int
 cci_get_holdability (int mapped_conn_id)
 {
@@ -4949,9 +5260,10 @@ cas_connect_internal (T_CON_HANDLE * con_handle, T_CCI_ERROR * err_buf,
 		      int *connect)
 {
   int error = CCI_ER_NO_ERROR;
-  int i;
+  int i, k, start = 0;
   int remained_time = 0;
   int retry = 0;
+  struct timeval connect_start;
 
   assert (connect != NULL);
 
@@ -4982,6 +5294,9 @@ cas_connect_internal (T_CON_HANDLE * con_handle, T_CCI_ERROR * err_buf,
       return CCI_ER_NO_ERROR;
     }
 
+  /* server handles waiting for a deferred close went away with the CAS */
+  con_handle->deferred_close_handle_count = 0;
+
   if (con_handle->alter_host_count == 0)
     {
       error = net_connect_srv (con_handle, con_handle->alter_host_id, err_buf,
@@ -4993,16 +5308,27 @@ cas_connect_internal (T_CON_HANDLE * con_handle, T_CCI_ERROR * err_buf,
 	}
     }
 
+  if (con_handle->load_balance)
+    {
+      start = hm_pick_alter_host (con_handle);
+    }
+
   do
     {
-      for (i = 0; i < con_handle->alter_host_count; i++)
+      for (k = 0; k < con_handle->alter_host_count; k++)
 	{
+	  i = (start + k) % con_handle->alter_host_count;
+
 	  /* if all hosts turn out to be unreachable,
 	   *  ignore host reachability and try one more time
 	   */
 	  if (hm_is_host_reachable (con_handle, i) || retry)
 	    {
+	      gettimeofday (&connect_start, NULL);
+	      hm_host_connect_begin (con_handle, i);
 	      error = net_connect_srv (con_handle, i, err_buf, remained_time);
+	      hm_host_connect_end (con_handle, i, (error == CCI_ER_NO_ERROR) ?
+				   get_elapsed_time (&connect_start) : -1);
 	      if (error == CCI_ER_NO_ERROR)
 		{
 		  *connect = 1;
@@ -5857,7 +6183,14 @@ T_CCI_DATASOURCE *
 cci_datasource_create (T_CCI_PROPERTIES * prop, T_CCI_ERROR * err_buf)
 {
   T_CCI_DATASOURCE *ds = NULL;
-  int i;
+  int i, num_threads;
+  T_CCI_CONN id;
+  char new_url[LINE_MAX];
+  pthread_t warm_th;
+#if !defined(WINDOWS)
+  pthread_attr_t thread_attr;
+#endif /* WINDOWS */
+  pthread_attr_t *thread_attr_p = NULL;
 
   T_CCI_ERROR latest_err_buf;
 
@@ -5997,8 +6330,27 @@ cci_datasource_create (T_CCI_PROPERTIES * prop, T_CCI_ERROR * err_buf)
       goto create_datasource_error;
     }
 
+  if (!cci_property_get_int (prop, CCI_DS_KEY_IDLE_TIMEOUT,
+			     &ds->idle_timeout,
+			     CCI_DS_IDLE_TIMEOUT_DEFAULT, 0, INT_MAX,
+			     &latest_err_buf))
+    {
+      goto create_datasource_error;
+    }
+
+  if (!cci_datasource_make_url (prop, new_url, ds->url, &latest_err_buf))
+    {
+      goto create_datasource_error;
+    }
+  ds->conn_url = strdup (new_url);
+
   ds->con_handles = CALLOC (ds->max_pool_size, sizeof (T_CCI_CONN));
-  if (ds->con_handles == NULL)
+  ds->idle_slots = CALLOC (ds->max_pool_size, sizeof (int));
+  ds->closed_slots = CALLOC (ds->max_pool_size, sizeof (int));
+  ds->released_at = CALLOC (ds->max_pool_size, sizeof (struct timeval));
+  if (ds->conn_url == NULL || ds->con_handles == NULL
+      || ds->idle_slots == NULL || ds->closed_slots == NULL
+      || ds->released_at == NULL)
     {
       set_error_buffer (&latest_err_buf, CCI_ER_NO_MORE_MEMORY,
 			"memory allocation error: %s", strerror (errno));
@@ -6024,33 +6376,72 @@ cci_datasource_create (T_CCI_PROPERTIES * prop, T_CCI_ERROR * err_buf)
   pthread_cond_init ((pthread_cond_t *) ds->cond, NULL);
 
   ds->num_idle = ds->pool_size;
-  for (i = 0; i < ds->max_pool_size; i++)
+
+  /*
+   * Only the first connection is opened here, to report a bad url or
+   * login. The rest of pool_size is opened by warm-up threads, and
+   * connections beyond that when a borrower first needs them.
+   */
+  id = cci_datasource_connect (ds, 0);
+  if (id < 0)
     {
-      T_CON_HANDLE *handle;
-      int id;
-      char new_url[LINE_MAX];
+      set_error_buffer (&latest_err_buf, CCI_ER_CONNECT,
+			"Could not connect to database");
+      goto create_datasource_error;
+    }
+  ds->con_handles[0] = id;
+  gettimeofday (&ds->released_at[0], NULL);
+  ds->stats.num_open = 1;
 
-      if (!cci_datasource_make_url (prop, new_url, ds->url, &latest_err_buf))
-	{
-	  goto create_datasource_error;
-	}
+  for (i = ds->max_pool_size - 1; i >= ds->pool_size; i--)
+    {
+      ds->closed_slots[ds->num_closed_slots++] = i;
+    }
+  ds->idle_slots[ds->num_idle_slots++] = 0;
 
-      id = cci_connect_with_url (new_url, ds->user, ds->pass);
-      if (id < 0)
+  ds->warm_next = 1;
+  ds->warm_end = ds->pool_size;
+  num_threads = MIN (ds->pool_size - 1, CCI_DS_WARM_THREADS_MAX);
+
+#if !defined(WINDOWS)
+  pthread_attr_init (&thread_attr);
+  pthread_attr_setdetachstate (&thread_attr, PTHREAD_CREATE_DETACHED);
+  thread_attr_p = &thread_attr;
+#endif /* WINDOWS */
+  for (i = 0; i < num_threads; i++)
+    {
+      /* threads already started decrement it under the mutex */
+      pthread_mutex_lock ((pthread_mutex_t *) ds->mutex);
+      ds->num_warming++;
+      pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
+
+      if (pthread_create (&warm_th, thread_attr_p, cci_datasource_warm_thread,
+			  (void *) ds) != 0)
 	{
-	  set_error_buffer (&latest_err_buf, CCI_ER_CONNECT,
-			    "Could not connect to database");
-	  goto create_datasource_error;
+	  pthread_mutex_lock ((pthread_mutex_t *) ds->mutex);
+	  ds->num_warming--;
+	  pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
+	  break;
 	}
+#if defined(WINDOWS)
+      /* the thread port has no attributes; drop the handle to detach */
+      CloseHandle (warm_th);
+#endif /* WINDOWS */
+    }
+#if !defined(WINDOWS)
+  pthread_attr_destroy (&thread_attr);
+#endif /* WINDOWS */
 
-      if (hm_get_connection (id, &handle) != CCI_ER_NO_ERROR)
+  if (i == 0)
+    {
+      /* no warm-up thread started: open the slots on demand */
+      pthread_mutex_lock ((pthread_mutex_t *) ds->mutex);
+      for (i = ds->warm_end - 1; i >= ds->warm_next; i--)
 	{
-	  set_error_buffer (&latest_err_buf, CCI_ER_CON_HANDLE, NULL);
-	  goto create_datasource_error;
+	  ds->closed_slots[ds->num_closed_slots++] = i;
 	}
-      handle->datasource = ds;
-      ds->con_handles[i] = handle->id;
-      handle->used = false;
+      ds->warm_next = ds->warm_end;
+      pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
     }
 
   ds->is_init = 1;
@@ -6083,6 +6474,10 @@ create_datasource_error:
       FREE (ds->cond);
     }
   FREE_MEM (ds->con_handles);
+  FREE_MEM (ds->idle_slots);
+  FREE_MEM (ds->closed_slots);
+  FREE_MEM (ds->released_at);
+  FREE_MEM (ds->conn_url);
   FREE_MEM (ds);
 
   copy_error_buffer (err_buf, &latest_err_buf);
@@ -6103,6 +6498,13 @@ cci_datasource_destroy (T_CCI_DATASOURCE * ds)
   /* critical section begin */
   pthread_mutex_lock ((pthread_mutex_t *) ds->mutex);
 
+  ds->is_destroying = 1;
+  while (ds->num_warming > 0)
+    {
+      pthread_cond_wait ((pthread_cond_t *) ds->cond,
+			 (pthread_mutex_t *) ds->mutex);
+    }
+
   if (ds->con_handles)
     {
       for (i = 0; i < ds->max_pool_size; i++)
@@ -6126,6 +6528,10 @@ cci_datasource_destroy (T_CCI_DATASOURCE * ds)
 	}
       FREE_MEM (ds->con_handles);
     }
+  FREE_MEM (ds->idle_slots);
+  FREE_MEM (ds->closed_slots);
+  FREE_MEM (ds->released_at);
+  FREE_MEM (ds->conn_url);
 
   /* critical section end */
   pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
@@ -6252,6 +6658,21 @@ cci_datasource_change_property (T_CCI_DATASOURCE * ds, const char *key,
 
       ds->num_idle += (v - ds->pool_size);
       ds->pool_size = v;
+      cci_datasource_grant_waiters (ds);
+    }
+  else if (strcasecmp (key, CCI_DS_PROPERTY_IDLE_TIMEOUT) == 0)
+    {
+      int v;
+
+      if (!cci_property_get_int (properties, CCI_DS_KEY_IDLE_TIMEOUT, &v,
+				 CCI_DS_IDLE_TIMEOUT_DEFAULT, 0, INT_MAX,
+				 &err_buf))
+	{
+	  error = err_buf.err_code;
+	  goto change_property_end;
+	}
+
+      ds->idle_timeout = v;
     }
   else
     {
@@ -6270,11 +6691,276 @@ change_property_end:
   return error;
 }
 
+#define DS_HAS_FREE_SLOT(ds) \
+  ((ds)->num_idle > 0 && ((ds)->num_idle_slots > 0 \
+			  || (ds)->num_closed_slots > 0))
+
+/*
+ * Take a permit and a slot, preferring one that is already connected.
+ * Called with ds->mutex held.
+ */
+static int
+cci_datasource_pop_idle (T_CCI_DATASOURCE * ds)
+{
+  assert (DS_HAS_FREE_SLOT (ds));
+
+  ds->num_idle--;
+  if (ds->num_idle_slots > 0)
+    {
+      return ds->idle_slots[--ds->num_idle_slots];
+    }
+  return ds->closed_slots[--ds->num_closed_slots];
+}
+
+/*
+ * Return a slot that is not borrowed to the idle or closed stack.
+ * Called with ds->mutex held.
+ */
+static void
+cci_datasource_put_slot (T_CCI_DATASOURCE * ds, int slot)
+{
+  if (ds->con_handles[slot] > 0)
+    {
+      gettimeofday (&ds->released_at[slot], NULL);
+      ds->idle_slots[ds->num_idle_slots++] = slot;
+    }
+  else
+    {
+      ds->con_handles[slot] = 0;
+      ds->closed_slots[ds->num_closed_slots++] = slot;
+    }
+}
+
+/*
+ * Open a connection for the given slot. Returns its resolved id, which
+ * is not mapped until the connection is borrowed.
+ */
+static T_CCI_CONN
+cci_datasource_connect (T_CCI_DATASOURCE * ds, int slot)
+{
+  T_CON_HANDLE *handle;
+  T_CCI_CONN mapped_id, id;
+
+  mapped_id = cci_connect_with_url (ds->conn_url, ds->user, ds->pass);
+  if (mapped_id < 0)
+    {
+      return CCI_ER_CONNECT;
+    }
+
+  if (hm_get_connection (mapped_id, &handle) != CCI_ER_NO_ERROR)
+    {
+      return CCI_ER_CON_HANDLE;
+    }
+  handle->datasource = ds;
+  handle->datasource_slot = slot;
+  id = handle->id;
+
+  hm_release_connection (mapped_id, &handle);
+  handle->used = false;
+
+  return id;
+}
+
+/*
+ * Close at most one connection that has stayed idle longer than
+ * idle_timeout, oldest first. Called with ds->mutex held; returns the
+ * resolved id to disconnect after unlocking, or 0.
+ */
+static T_CCI_CONN
+cci_datasource_shrink (T_CCI_DATASOURCE * ds)
+{
+  struct timeval now;
+  T_CCI_CONN id;
+  int slot;
+
+  if (ds->idle_timeout <= 0 || ds->num_idle_slots <= 1)
+    {
+      return 0;
+    }
+
+  /* the bottom of the stack was released first */
+  slot = ds->idle_slots[0];
+  gettimeofday (&now, NULL);
+  if (ELAPSED_MSECS (now, ds->released_at[slot]) < ds->idle_timeout)
+    {
+      return 0;
+    }
+
+  memmove (ds->idle_slots, ds->idle_slots + 1,
+	   sizeof (int) * (--ds->num_idle_slots));
+  id = ds->con_handles[slot];
+  ds->con_handles[slot] = 0;
+  ds->closed_slots[ds->num_closed_slots++] = slot;
+  ds->stats.num_open--;
+
+  return id;
+}
+
+static THREAD_RET_T THREAD_CALLING_CONVENTION
+cci_datasource_warm_thread (void *arg)
+{
+  T_CCI_DATASOURCE *ds = (T_CCI_DATASOURCE *) arg;
+  T_CCI_CONN id;
+  int slot;
+
+  pthread_mutex_lock ((pthread_mutex_t *) ds->mutex);
+  while (!ds->is_destroying && ds->warm_next < ds->warm_end)
+    {
+      slot = ds->warm_next++;
+      pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
+
+      id = cci_datasource_connect (ds, slot);
+
+      pthread_mutex_lock ((pthread_mutex_t *) ds->mutex);
+      if (id > 0)
+	{
+	  ds->con_handles[slot] = id;
+	  ds->stats.num_open++;
+	}
+      /* a failed slot is retried by the borrower that takes it */
+      cci_datasource_put_slot (ds, slot);
+      cci_datasource_grant_waiters (ds);
+    }
+
+  if (--ds->num_warming == 0)
+    {
+      pthread_cond_broadcast ((pthread_cond_t *) ds->cond);
+    }
+  pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
+
+  return (THREAD_RET_T) 0;
+}
+
+/* called with ds->mutex held */
+static void
+cci_datasource_grant_waiters (T_CCI_DATASOURCE * ds)
+{
+  T_DATASOURCE_WAITER *waiter;
+
+  while (ds->waiter_head != NULL && DS_HAS_FREE_SLOT (ds))
+    {
+      waiter = (T_DATASOURCE_WAITER *) ds->waiter_head;
+      ds->waiter_head = waiter->next;
+      if (waiter->next != NULL)
+	{
+	  waiter->next->prev = NULL;
+	}
+      else
+	{
+	  ds->waiter_tail = NULL;
+	}
+      ds->stats.num_waiting--;
+
+      waiter->slot = cci_datasource_pop_idle (ds);
+      pthread_cond_signal (&waiter->cond);
+    }
+}
+
+/*
+ * Queue behind earlier borrowers and wait up to max_wait msecs for a
+ * connection to be handed over. Called with ds->mutex held; returns the
+ * granted con_handles index or an error code.
+ */
+static int
+cci_datasource_wait (T_CCI_DATASOURCE * ds, T_CCI_ERROR * err_buf)
+{
+  T_DATASOURCE_WAITER waiter;
+  struct timespec ts;
+  struct timeval start, end;
+  int r = 0, error = CCI_ER_NO_ERROR;
+  int msec, bucket;
+
+  gettimeofday (&start, NULL);
+  ts.tv_sec = start.tv_sec + (ds->max_wait / 1000);
+  ts.tv_nsec = (start.tv_usec + (ds->max_wait % 1000) * 1000) * 1000;
+  if (ts.tv_nsec >= 1000000000)
+    {
+      ts.tv_sec += 1;
+      ts.tv_nsec -= 1000000000;
+    }
+
+  pthread_cond_init (&waiter.cond, NULL);
+  waiter.slot = -1;
+  waiter.next = NULL;
+  waiter.prev = (T_DATASOURCE_WAITER *) ds->waiter_tail;
+  if (waiter.prev != NULL)
+    {
+      waiter.prev->next = &waiter;
+    }
+  else
+    {
+      ds->waiter_head = &waiter;
+    }
+  ds->waiter_tail = &waiter;
+  ds->stats.num_waiting++;
+  ds->stats.num_wait++;
+
+  while (waiter.slot < 0)
+    {
+      r = pthread_cond_timedwait (&waiter.cond,
+				  (pthread_mutex_t *) ds->mutex, &ts);
+      if (waiter.slot >= 0 || (r != 0 && r != EINTR))
+	{
+	  break;
+	}
+    }
+
+  if (waiter.slot < 0)
+    {
+      /* still queued: unlink */
+      if (waiter.prev != NULL)
+	{
+	  waiter.prev->next = waiter.next;
+	}
+      else
+	{
+	  ds->waiter_head = waiter.next;
+	}
+      if (waiter.next != NULL)
+	{
+	  waiter.next->prev = waiter.prev;
+	}
+      else
+	{
+	  ds->waiter_tail = waiter.prev;
+	}
+      ds->stats.num_waiting--;
+
+      if (r == ETIMEDOUT)
+	{
+	  ds->stats.num_timeout++;
+	  set_error_buffer (err_buf, CCI_ER_DATASOURCE_TIMEOUT, NULL);
+	  error = CCI_ER_DATASOURCE_TIMEOUT;
+	}
+      else
+	{
+	  set_error_buffer (err_buf, CCI_ER_DATASOURCE_TIMEDWAIT,
+			    "pthread_cond_timedwait : %d", r);
+	  error = CCI_ER_DATASOURCE_TIMEDWAIT;
+	}
+    }
+  else
+    {
+      gettimeofday (&end, NULL);
+      msec = ELAPSED_MSECS (end, start);
+      for (bucket = 0; bucket < CCI_DS_WAIT_HISTOGRAM_SIZE - 1 && msec > 0;
+	   bucket++)
+	{
+	  msec >>= 1;
+	}
+      ds->stats.wait_histogram[bucket]++;
+    }
+
+  pthread_cond_destroy (&waiter.cond);
+
+  return (error == CCI_ER_NO_ERROR) ? waiter.slot : error;
+}
+
 T_CCI_CONN
 cci_datasource_borrow (T_CCI_DATASOURCE * ds, T_CCI_ERROR * err_buf)
 {
   T_CCI_CONN id = -1, mapped_id;
-  int i;
+  int slot;
 
   reset_error_buffer (err_buf);
 
@@ -6287,54 +6973,43 @@ cci_datasource_borrow (T_CCI_DATASOURCE * ds, T_CCI_ERROR * err_buf)
 
   /* critical section begin */
   pthread_mutex_lock ((pthread_mutex_t *) ds->mutex);
-  if (ds->num_idle <= 0)
+  if (ds->waiter_head == NULL && DS_HAS_FREE_SLOT (ds))
     {
-      /* wait max_wait msecs */
-      struct timespec ts;
-      struct timeval tv;
-      int r;
-
-      gettimeofday (&tv, NULL);
-      ts.tv_sec = tv.tv_sec + (ds->max_wait / 1000);
-      ts.tv_nsec = (tv.tv_usec + (ds->max_wait % 1000) * 1000) * 1000;
-      if (ts.tv_nsec > 1000000000)
-	{
-	  ts.tv_sec += 1;
-	  ts.tv_nsec -= 1000000000;
-	}
-
-      while (ds->num_idle <= 0)
+      slot = cci_datasource_pop_idle (ds);
+    }
+  else
+    {
+      slot = cci_datasource_wait (ds, err_buf);
+      if (slot < 0)
 	{
-	  r = pthread_cond_timedwait ((pthread_cond_t *) ds->cond,
-				      (pthread_mutex_t *) ds->mutex, &ts);
-	  if (r == ETIMEDOUT)
-	    {
-	      set_error_buffer (err_buf, CCI_ER_DATASOURCE_TIMEOUT, NULL);
-	      pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
-	      return CCI_ER_DATASOURCE_TIMEOUT;
-	    }
-	  else if (r != 0)
-	    {
-	      set_error_buffer (err_buf, CCI_ER_DATASOURCE_TIMEDWAIT,
-				"pthread_cond_timedwait : %d", r);
-	      pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
-	      return CCI_ER_DATASOURCE_TIMEDWAIT;
-	    }
+	  pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
+	  return slot;
 	}
     }
 
-  assert (ds->num_idle > 0);
-
-  for (i = 0; i < ds->max_pool_size; i++)
+  id = ds->con_handles[slot];
+  if (id <= 0)
     {
-      if (ds->con_handles[i] > 0)
+      /* not connected yet: connect outside the critical section */
+      pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
+      id = cci_datasource_connect (ds, slot);
+      pthread_mutex_lock ((pthread_mutex_t *) ds->mutex);
+
+      if (id < 0)
 	{
-	  id = ds->con_handles[i];
-	  ds->con_handles[i] = -id;
-	  ds->num_idle--;
-	  break;
+	  cci_datasource_put_slot (ds, slot);
+	  ds->num_idle++;
+	  cci_datasource_grant_waiters (ds);
+	  pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
+
+	  set_error_buffer (err_buf, CCI_ER_CONNECT,
+			    "Could not connect to database");
+	  return CCI_ER_CONNECT;
 	}
+      ds->stats.num_open++;
     }
+  ds->con_handles[slot] = -id;
+  ds->stats.num_borrow++;
   pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
   /* critical section end */
 
@@ -6373,7 +7048,8 @@ static int
 cci_datasource_release_internal (T_CCI_DATASOURCE * ds,
 				 T_CON_HANDLE * con_handle)
 {
-  int i;
+  int slot;
+  T_CCI_CONN victim;
 
   if (con_handle->datasource != ds)
     {
@@ -6391,18 +7067,12 @@ cci_datasource_release_internal (T_CCI_DATASOURCE * ds,
       qe_close_req_handle_all (con_handle);
     }
 
+  slot = con_handle->datasource_slot;
+
   /* critical section begin */
   pthread_mutex_lock ((pthread_mutex_t *) ds->mutex);
-  for (i = 0; i < ds->max_pool_size; i++)
-    {
-      if (ds->con_handles[i] == -(con_handle->id))
-	{
-	  ds->con_handles[i] = con_handle->id;
-	  break;
-	}
-    }
-
-  if (i == ds->max_pool_size)
+  if (slot < 0 || slot >= ds->max_pool_size
+      || ds->con_handles[slot] != -(con_handle->id))
     {
       /* could not found con_handles */
       pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
@@ -6411,9 +7081,17 @@ cci_datasource_release_internal (T_CCI_DATASOURCE * ds,
       return 0;
     }
 
+  ds->con_handles[slot] = con_handle->id;
+  cci_datasource_put_slot (ds, slot);
   ds->num_idle++;
-  pthread_cond_signal ((pthread_cond_t *) ds->cond);
+  cci_datasource_grant_waiters (ds);
+  victim = cci_datasource_shrink (ds);
   pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
+
+  if (victim > 0)
+    {
+      cci_disconnect_force (victim, true);
+    }
   /* critical section end */
 
   return 0;
@@ -6457,6 +7135,26 @@ cci_datasource_release (T_CCI_DATASOURCE * ds, T_CCI_CONN mapped_conn_id,
   return ret;
 }
 
+int
+cci_datasource_get_stats (T_CCI_DATASOURCE * ds,
+			  T_CCI_DATASOURCE_STATS * stats)
+{
+  if (ds == NULL || !ds->is_init)
+    {
+      return CCI_ER_INVALID_DATASOURCE;
+    }
+  if (stats == NULL)
+    {
+      return CCI_ER_INVALID_ARGS;
+    }
+
+  pthread_mutex_lock ((pthread_mutex_t *) ds->mutex);
+  *stats = ds->stats;
+  pthread_mutex_unlock ((pthread_mutex_t *) ds->mutex);
+
+  return CCI_ER_NO_ERROR;
+}
+
 int
 cci_set_allocators (CCI_MALLOC_FUNCTION malloc_func,
 		    CCI_FREE_FUNCTION free_func,
@@ -203,7 +203,7 @@ extern "C"
 
 /* number of connection that are borrowed */
 #define CCI_DS_PROPERTY_POOL_SIZE			"pool_size"
-/* number of connection that are created when the pool is started */
+/* upper limit of pool_size; connections are opened when first needed */
 #define CCI_DS_PROPERTY_MAX_POOL_SIZE			"max_pool_size"
 /* max wait msec for a connection to be returned, or -1 to wait indefinitely */
 #define CCI_DS_PROPERTY_MAX_WAIT			"max_wait"
@@ -223,6 +223,8 @@ extern "C"
 #define CCI_DS_PROPERTY_DEFAULT_ISOLATION		"default_isolation"
 /* default lock timeout in sec for connections created by pool*/
 #define CCI_DS_PROPERTY_DEFAULT_LOCK_TIMEOUT		"default_lock_timeout"
+/* close connections left idle for this many msecs, or 0 to keep them */
+#define CCI_DS_PROPERTY_IDLE_TIMEOUT			"idle_timeout"
 
 /* for cci auto_comit mode support */
   typedef enum
@@ -645,7 +647,8 @@ extern "C"
     CCI_DS_KEY_DEFAULT_AUTOCOMMIT,
     CCI_DS_KEY_DEFAULT_ISOLATION,
     CCI_DS_KEY_DEFAULT_LOCK_TIMEOUT,
-    CCI_DS_KEY_MAX_POOL_SIZE
+    CCI_DS_KEY_MAX_POOL_SIZE,
+    CCI_DS_KEY_IDLE_TIMEOUT
   } T_CCI_DATASOURCE_KEY;
 
 #if !defined(CAS)
@@ -705,12 +708,42 @@ extern "C"
     char *db_server;
   } T_CCI_SHARD_INFO;
 
+  typedef struct
+  {
+    int idle;			/* connections waiting in the pool */
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int rejected;	/* releases refused by max_idle_per_key */
+    unsigned int evicted;	/* closed after the idle timeout */
+  } T_CCI_CON_POOL_STATS;
+
+#define CCI_DS_WAIT_HISTOGRAM_SIZE	16
+
+  /*
+   * wait_histogram[0] counts borrows that waited less than 1 msec,
+   * wait_histogram[i] those that waited 2^(i-1) to 2^i - 1 msecs; the
+   * last bucket also takes everything longer.
+   */
+  typedef struct
+  {
+    unsigned int num_borrow;
+    unsigned int num_wait;	/* borrows that had to queue */
+    unsigned int num_timeout;
+    int num_waiting;		/* borrowers queued right now */
+    int num_open;		/* connections currently open */
+    unsigned int wait_histogram[CCI_DS_WAIT_HISTOGRAM_SIZE];
+  } T_CCI_DATASOURCE_STATS;
+
   /* memory allocators */
   typedef void *(*CCI_MALLOC_FUNCTION) (size_t);
   typedef void *(*CCI_CALLOC_FUNCTION) (size_t, size_t);
   typedef void *(*CCI_REALLOC_FUNCTION) (void *, size_t);
   typedef void (*CCI_FREE_FUNCTION) (void *);
 
+  /* receives each value read by cci_fetch_rows */
+  typedef void (*CCI_FETCH_VALUE_FUNCTION) (void *arg, int col_no,
+					    void *value, int indicator);
+
 /************************************************************************
  * EXPORTED FUNCTION PROTOTYPES						*
  ************************************************************************/
@@ -742,6 +775,11 @@ extern "C"
 			     int index,
 			     T_CCI_A_TYPE a_type,
 			     void *value, T_CCI_U_TYPE u_type, char flag);
+  extern int cci_bind_param_ex (int req_handle,
+				int index,
+				T_CCI_A_TYPE a_type,
+				void *value, int length,
+				T_CCI_U_TYPE u_type, char flag);
   extern int cci_execute (int req_handle,
 			  char flag, int max_col_size, T_CCI_ERROR * err_buf);
   extern int cci_prepare_and_execute (int con_handle, char *sql_stmt,
@@ -761,9 +799,15 @@ extern "C"
 			 int offset,
 			 T_CCI_CURSOR_POS origin, T_CCI_ERROR * err_buf);
   extern int cci_fetch_size (int req_handle, int fetch_size);
+  extern int cci_fetch_size_adaptive (int req_handle, int max_bytes);
+  extern int cci_fetch_read_ahead (int req_handle, int flag);
   extern int cci_fetch (int req_handle, T_CCI_ERROR * err_buf);
   extern int cci_get_data (int req_handle,
 			   int col_no, int type, void *value, int *indicator);
+  extern int cci_fetch_rows (int req_handle, int max_rows, int num_cols,
+			     const int *a_types,
+			     CCI_FETCH_VALUE_FUNCTION value_fn, void *arg,
+			     T_CCI_ERROR * err_buf);
   extern int cci_schema_info (int con_handle,
 			      T_CCI_SCH_TYPE type,
 			      char *arg1, char *arg2,
@@ -787,6 +831,10 @@ extern "C"
 				 CCI_AUTOCOMMIT_MODE autocommit_mode);
   extern int cci_set_holdability (int con_handle_id, int holdable);
   extern int cci_get_holdability (int con_handle_id);
+  extern int cci_set_statement_pool_size (int con_handle_id, int max_size);
+  extern int cci_set_con_pool_limits (int max_idle_per_key,
+				      int idle_timeout);
+  extern int cci_get_con_pool_stats (T_CCI_CON_POOL_STATS * stats);
   extern int cci_set_login_timeout (int mapped_conn_id, int timeout,
 				    T_CCI_ERROR * err_buf);
   extern int cci_get_login_timeout (int mapped_conn_id, int *timeout,
@@ -951,6 +999,8 @@ extern "C"
   extern int cci_datasource_change_property (T_CCI_DATASOURCE * ds,
 					     const char *key,
 					     const char *val);
+  extern int cci_datasource_get_stats (T_CCI_DATASOURCE * ds,
+				       T_CCI_DATASOURCE_STATS * stats);
 
   extern int cci_set_query_timeout (int req_h_id, int timeout);
   extern int cci_get_query_timeout (int req_h_id);
@@ -278,6 +278,20 @@ extern "C"
 
     int num_idle;
     int *con_handles;		/* realloc by pool_size */
+    int *idle_slots;		/* idle con_handles indexes, LIFO */
+    int num_idle_slots;
+    int *closed_slots;		/* con_handles indexes not connected yet */
+    int num_closed_slots;
+    struct timeval *released_at;	/* per con_handles index */
+    int idle_timeout;
+    char *conn_url;		/* url with the pool properties applied */
+    int warm_next;		/* next slot for the warm-up threads */
+    int warm_end;
+    int num_warming;		/* warm-up threads still running */
+    int is_destroying;
+    void *waiter_head;		/* T_DATASOURCE_WAITER queue, FIFO */
+    void *waiter_tail;
+    T_CCI_DATASOURCE_STATS stats;
   };
 
   typedef unsigned int (*HASH_FUNC) (void *key, unsigned int ht_size);
@@ -42,6 +42,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <string.h>
 
 #if defined(WINDOWS)
@@ -50,6 +51,7 @@
 #else
 #include <netdb.h>
 #include <pthread.h>
+#include <sys/time.h>
 #endif
 
 /************************************************************************
@@ -69,7 +71,19 @@
  * PRIVATE DEFINITIONS							*
  ************************************************************************/
 
-#define MAX_CON_HANDLE                  1024
+#define MAX_CON_HANDLE                  (INT_MAX / RESOLVED_ID_FACTOR)
+#define CON_HANDLE_SEGMENT_SIZE         256
+#define CON_HANDLE_SEGMENT_MAX          \
+  ((MAX_CON_HANDLE + CON_HANDLE_SEGMENT_SIZE - 1) / CON_HANDLE_SEGMENT_SIZE)
+
+#define HOST_PROBE_INTERVAL_MIN         1	/* sec, first retry of a lost host */
+#define HEALTH_CHECK_TICK               1	/* sec */
+
+#define HOST_STATUS_SEGMENT_SIZE        64
+#define HOST_STATUS_SEGMENT_MAX         256
+#define HOST_STATUS(INDEX)              \
+  (host_status_segments[(INDEX) / HOST_STATUS_SEGMENT_SIZE]  \
+   [(INDEX) % HOST_STATUS_SEGMENT_SIZE])
 
 #define REQ_HANDLE_ALLOC_SIZE           256
 
@@ -83,9 +97,25 @@ typedef struct
 {
   T_ALTER_HOST host;		/* host info (ip, port) */
   bool is_reachable;
+  int rtt_msec;			/* smoothed health check time, -1 if unknown */
+  int connect_msec;		/* smoothed connect time, -1 if unknown */
+  int num_connecting;		/* connects in progress */
+  int probe_interval;		/* sec, doubles while the host is down */
+  time_t next_probe_time;
 } T_HOST_STATUS;
 
-static T_HOST_STATUS host_status[MAX_CON_HANDLE];
+/*
+ * Connection handles live in fixed-size segments that are allocated as
+ * the number of open connections grows and are never freed, so a lookup
+ * by id needs no lock. Unused ids are chained through next_free.
+ */
+typedef struct
+{
+  T_CON_HANDLE *handle[CON_HANDLE_SEGMENT_SIZE];
+  int next_free[CON_HANDLE_SEGMENT_SIZE];
+} T_CON_HANDLE_SEGMENT;
+
+static T_HOST_STATUS *host_status_segments[HOST_STATUS_SEGMENT_MAX];
 static int host_status_count = 0;
 
 #if defined(WINDOWS)
@@ -94,26 +124,70 @@ HANDLE host_status_mutex;
 T_MUTEX host_status_mutex = PTHREAD_MUTEX_INITIALIZER;
 #endif
 
-static int conn_pool[CCI_MAX_CONNECTION_POOL];
-static unsigned int num_conn_pool = 0;
+/* random state of hm_pick_alter_host, guarded by host_status_mutex */
+static struct drand48_data host_pick_rand;
+static bool host_pick_rand_seeded = false;
+
+/*
+ * Idle connections released with CCI_PCONNECT are kept per
+ * (host, port, db, user, password) key, most recently released first.
+ */
+#define CON_POOL_KEY_BUF_SIZE           256
+#define CON_POOL_SWEEP_INTERVAL         1	/* sec */
+
+typedef struct t_con_pool_entry T_CON_POOL_ENTRY;
+struct t_con_pool_entry
+{
+  char *key;
+  T_CON_HANDLE *head;
+  int count;
+  T_CON_POOL_ENTRY *next;
+};
+
+static MHT_TABLE *con_pool_table = NULL;
+static T_CON_POOL_ENTRY *con_pool_entries = NULL;
+static int con_pool_max_idle_per_key = CCI_MAX_CONNECTION_POOL;
+static int con_pool_idle_timeout = 0;	/* sec, 0 = no timeout */
+static time_t con_pool_last_sweep = 0;
+static T_CCI_CON_POOL_STATS con_pool_stats;
+
+#if defined(WINDOWS)
+HANDLE con_pool_mutex;
+#else
+T_MUTEX con_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
 
 /************************************************************************
  * PRIVATE FUNCTION PROTOTYPES						*
  ************************************************************************/
 
-static int compare_conn_info (unsigned char *ip_addr, int port, char *dbname,
-			      char *dbuser, char *dbpasswd,
-			      T_CON_HANDLE * con_handle);
+static char *con_pool_make_key (unsigned char *ip_addr, int port,
+				char *dbname, char *dbuser, char *dbpasswd,
+				char *buf, int buf_size);
+static int con_pool_key_eq (void *key1, void *key2);
+static bool con_pool_is_expired (T_CON_HANDLE * con_handle, time_t now);
+static T_CON_HANDLE *con_pool_sweep (time_t now);
 static int init_con_handle (T_CON_HANDLE * con_handle, char *ip_str, int port,
 			    char *db_name, char *db_user, char *db_passwd);
 static int new_con_handle_id (void);
+static void free_con_handle_id (int handle_id);
+static int con_handle_segment_grow (void);
+static T_CON_HANDLE *con_handle_lookup (int handle_id);
 static int new_req_handle_id (T_CON_HANDLE * con_handle);
+static void free_req_handle_id (T_CON_HANDLE * con_handle, int handle_id);
+static T_REQ_HANDLE *req_handle_obj_alloc (T_CON_HANDLE * con_handle);
+static void req_handle_obj_free (T_CON_HANDLE * con_handle,
+				 T_REQ_HANDLE * req_handle);
 static void con_handle_content_free (T_CON_HANDLE * con_handle);
 static void ipstr2uchar (char *ip_str, unsigned char *ip_addr);
 static int is_ip_str (char *ip_str);
 
 static int hm_find_host_status_index (unsigned char *ip_addr, int port);
+static int hm_add_host_status (unsigned char *ip_addr, int port);
+static int hm_host_cost (T_CON_HANDLE * con_handle, int host_id);
+static void hm_set_host_probe_result (T_ALTER_HOST * host, int rtt_msec,
+				      time_t now);
 static void hm_set_host_status_by_addr (unsigned char *ip_addr, int port,
 					bool is_reachable);
 static THREAD_RET_T THREAD_CALLING_CONVENTION hm_thread_health_checker (void
@@ -127,8 +201,15 @@ static THREAD_RET_T THREAD_CALLING_CONVENTION hm_thread_health_checker (void
  * PUBLIC VARIABLES							*
  ************************************************************************/
 
-static T_CON_HANDLE *con_handle_table[MAX_CON_HANDLE];
-static int con_handle_current_index;
+static T_CON_HANDLE_SEGMENT *con_handle_segments[CON_HANDLE_SEGMENT_MAX];
+static int con_handle_segment_count;
+static int con_handle_free_head;
+
+#if defined(WINDOWS)
+HANDLE con_handle_id_mutex;
+#else
+T_MUTEX con_handle_id_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
 /************************************************************************
  * PRIVATE VARIABLES							*
@@ -137,57 +218,272 @@ static int con_handle_current_index;
 /************************************************************************
  * IMPLEMENTATION OF PUBLIC FUNCTIONS	 				*
  ************************************************************************/
+static char *
+con_pool_make_key (unsigned char *ip_addr, int port, char *dbname,
+		   char *dbuser, char *dbpasswd, char *buf, int buf_size)
+{
+  char *key = buf;
+  int key_size;
+
+  dbname = (dbname ? dbname : (char *) "");
+  dbuser = (dbuser ? dbuser : (char *) "");
+  dbpasswd = (dbpasswd ? dbpasswd : (char *) "");
+
+  /* strings are length-prefixed so that no two logins share a key */
+  key_size = strlen (dbname) + strlen (dbuser) + strlen (dbpasswd) + 64;
+  if (key_size > buf_size)
+    {
+      key = (char *) MALLOC (key_size);
+      if (key == NULL)
+	{
+	  return NULL;
+	}
+    }
+
+  snprintf (key, key_size, "%d.%d.%d.%d:%d:%d:%s:%d:%s:%d:%s",
+	    ip_addr[0], ip_addr[1], ip_addr[2], ip_addr[3], port,
+	    (int) strlen (dbname), dbname, (int) strlen (dbuser), dbuser,
+	    (int) strlen (dbpasswd), dbpasswd);
+
+  return key;
+}
+
 static int
-compare_conn_info (unsigned char *ip_addr, int port, char *dbname,
-		   char *dbuser, char *dbpasswd, T_CON_HANDLE * con_handle)
+con_pool_key_eq (void *key1, void *key2)
+{
+  return strcmp ((char *) key1, (char *) key2) == 0;
+}
+
+static bool
+con_pool_is_expired (T_CON_HANDLE * con_handle, time_t now)
 {
-  if (memcmp (ip_addr, con_handle->ip_addr, 4) != 0 ||
-      port != con_handle->port ||
-      strcmp (dbname, con_handle->db_name) != 0 ||
-      strcmp (dbuser, con_handle->db_user) != 0 ||
-      strcmp (dbpasswd, con_handle->db_passwd) != 0)
+  return (con_pool_idle_timeout > 0
+	  && now - con_handle->pool_idle_since >= con_pool_idle_timeout);
+}
+
+/*
+ * Unlink every connection that has been idle longer than the timeout.
+ * Called with con_pool_mutex held; the caller closes the returned list
+ * after unlocking.
+ */
+static T_CON_HANDLE *
+con_pool_sweep (time_t now)
+{
+  T_CON_POOL_ENTRY *entry;
+  T_CON_HANDLE **link;
+  T_CON_HANDLE *expired = NULL;
+  T_CON_HANDLE *tail;
+
+  if (con_pool_idle_timeout <= 0
+      || now - con_pool_last_sweep < CON_POOL_SWEEP_INTERVAL)
     {
-      return 0;
+      return NULL;
     }
+  con_pool_last_sweep = now;
 
-  return 1;
+  for (entry = con_pool_entries; entry != NULL; entry = entry->next)
+    {
+      /* the list is ordered by release time, so the rest is older */
+      link = &entry->head;
+      while (*link != NULL && !con_pool_is_expired (*link, now))
+	{
+	  link = (T_CON_HANDLE **) & (*link)->pool_idle_next;
+	}
+
+      if (*link == NULL)
+	{
+	  continue;
+	}
+
+      for (tail = *link; tail != NULL;
+	   tail = (T_CON_HANDLE *) tail->pool_idle_next)
+	{
+	  entry->count--;
+	  con_pool_stats.idle--;
+	  con_pool_stats.evicted++;
+	  if (tail->pool_idle_next == NULL)
+	    {
+	      tail->pool_idle_next = expired;
+	      break;
+	    }
+	}
+
+      expired = *link;
+      *link = NULL;
+    }
+
+  return expired;
 }
 
 T_CON_HANDLE *
 hm_get_con_from_pool (unsigned char *ip_addr, int port, char *dbname,
 		      char *dbuser, char *dbpasswd)
 {
-  int con = -1;
-  unsigned int i;
+  char key_buf[CON_POOL_KEY_BUF_SIZE];
+  char *key;
+  T_CON_POOL_ENTRY *entry;
+  T_CON_HANDLE *con_handle = NULL;
 
-  for (i = 0; i < num_conn_pool; i++)
+  key = con_pool_make_key (ip_addr, port, dbname, dbuser, dbpasswd,
+			   key_buf, sizeof (key_buf));
+  if (key == NULL)
     {
-      if (compare_conn_info (ip_addr, port, dbname, dbuser, dbpasswd,
-			     con_handle_table[conn_pool[i] - 1]))
-	{
-	  con = conn_pool[i];
-	  conn_pool[i] = conn_pool[--num_conn_pool];
-	  break;
-	}
+      return NULL;
     }
 
-  if (con < 0)
+  MUTEX_LOCK (con_pool_mutex);
+
+  entry = NULL;
+  if (con_pool_table != NULL)
     {
-      return NULL;
+      entry = (T_CON_POOL_ENTRY *) mht_get (con_pool_table, key);
     }
 
-  return con_handle_table[con - 1];
+  /* expired connections are left for the sweep in hm_put_con_to_pool */
+  if (entry != NULL && entry->head != NULL
+      && !con_pool_is_expired (entry->head, time (NULL)))
+    {
+      con_handle = entry->head;
+      entry->head = (T_CON_HANDLE *) con_handle->pool_idle_next;
+      entry->count--;
+      con_handle->pool_idle_next = NULL;
+
+      con_pool_stats.idle--;
+      con_pool_stats.hits++;
+    }
+  else
+    {
+      con_pool_stats.misses++;
+    }
+
+  MUTEX_UNLOCK (con_pool_mutex);
+
+  if (key != key_buf)
+    {
+      FREE_MEM (key);
+    }
+
+  return con_handle;
 }
 
 int
 hm_put_con_to_pool (int con)
 {
-  if (num_conn_pool >= sizeof (conn_pool) / sizeof (int))
+  char key_buf[CON_POOL_KEY_BUF_SIZE];
+  char *key;
+  T_CON_POOL_ENTRY *entry;
+  T_CON_HANDLE *con_handle;
+  T_CON_HANDLE *expired;
+  time_t now;
+  int error = 0;
+
+  con_handle = con_handle_lookup (con);
+  if (con_handle == NULL)
     {
       return -1;
     }
-  conn_pool[num_conn_pool++] = con;
-  return 0;
+
+  key = con_pool_make_key (con_handle->ip_addr, con_handle->port,
+			   con_handle->db_name, con_handle->db_user,
+			   con_handle->db_passwd, key_buf, sizeof (key_buf));
+  if (key == NULL)
+    {
+      return -1;
+    }
+
+  now = time (NULL);
+
+  MUTEX_LOCK (con_pool_mutex);
+
+  expired = con_pool_sweep (now);
+
+  if (con_pool_table == NULL)
+    {
+      con_pool_table = mht_create (0, 64, mht_5strhash, con_pool_key_eq);
+    }
+
+  entry = NULL;
+  if (con_pool_table != NULL)
+    {
+      entry = (T_CON_POOL_ENTRY *) mht_get (con_pool_table, key);
+      if (entry == NULL)
+	{
+	  entry = (T_CON_POOL_ENTRY *) MALLOC (sizeof (T_CON_POOL_ENTRY));
+	  if (entry != NULL)
+	    {
+	      memset (entry, 0, sizeof (T_CON_POOL_ENTRY));
+	      ALLOC_COPY (entry->key, key);
+	      if (entry->key == NULL
+		  || mht_put_data (con_pool_table, entry->key, entry) == NULL)
+		{
+		  FREE_MEM (entry->key);
+		  FREE_MEM (entry);
+		}
+	      else
+		{
+		  entry->next = con_pool_entries;
+		  con_pool_entries = entry;
+		}
+	    }
+	}
+    }
+
+  if (entry == NULL || entry->count >= con_pool_max_idle_per_key)
+    {
+      con_pool_stats.rejected++;
+      error = -1;
+    }
+  else
+    {
+      con_handle->pool_idle_since = now;
+      con_handle->pool_idle_next = entry->head;
+      entry->head = con_handle;
+      entry->count++;
+      con_pool_stats.idle++;
+    }
+
+  MUTEX_UNLOCK (con_pool_mutex);
+
+  if (key != key_buf)
+    {
+      FREE_MEM (key);
+    }
+
+  while (expired != NULL)
+    {
+      con_handle = expired;
+      expired = (T_CON_HANDLE *) con_handle->pool_idle_next;
+
+      qe_con_close (con_handle);
+      hm_con_handle_free (con_handle);
+    }
+
+  return error;
+}
+
+int
+hm_con_pool_set_limits (int max_idle_per_key, int idle_timeout)
+{
+  if (max_idle_per_key < 0 || idle_timeout < 0)
+    {
+      return CCI_ER_INVALID_ARGS;
+    }
+
+  MUTEX_LOCK (con_pool_mutex);
+  con_pool_max_idle_per_key = max_idle_per_key;
+  con_pool_idle_timeout = idle_timeout;
+  con_pool_last_sweep = 0;
+  MUTEX_UNLOCK (con_pool_mutex);
+
+  return CCI_ER_NO_ERROR;
+}
+
+void
+hm_con_pool_get_stats (T_CCI_CON_POOL_STATS * stats)
+{
+  MUTEX_LOCK (con_pool_mutex);
+  *stats = con_pool_stats;
+  MUTEX_UNLOCK (con_pool_mutex);
 }
 
 int
@@ -212,12 +508,18 @@ hm_con_handle_table_init ()
 {
   int i;
 
-  for (i = 0; i < MAX_CON_HANDLE; i++)
+#if defined(WINDOWS)
+  MUTEX_INIT (con_handle_id_mutex);
+  MUTEX_INIT (con_pool_mutex);
+#endif
+
+  for (i = 0; i < CON_HANDLE_SEGMENT_MAX; i++)
     {
-      con_handle_table[i] = NULL;
+      con_handle_segments[i] = NULL;
     }
 
-  con_handle_current_index = 0;
+  con_handle_segment_count = 0;
+  con_handle_free_head = 0;
 }
 
 T_CON_HANDLE *
@@ -228,16 +530,10 @@ hm_con_handle_alloc (char *ip_str, int port, char *db_name, char *db_user,
   int error = 0;
   T_CON_HANDLE *con_handle = NULL;
 
-  handle_id = new_con_handle_id ();
-  if (handle_id <= 0)
-    {
-      goto error_end;
-    }
-
   con_handle = (T_CON_HANDLE *) MALLOC (sizeof (T_CON_HANDLE));
   if (con_handle == NULL)
     {
-      goto error_end;
+      return NULL;
     }
   error = init_con_handle (con_handle, ip_str, port, db_name, db_user,
 			   db_passwd);
@@ -246,8 +542,18 @@ hm_con_handle_alloc (char *ip_str, int port, char *db_name, char *db_user,
       goto error_end;
     }
 
-  con_handle_table[handle_id - 1] = con_handle;
+  /* taken last, so that an id is never handed out without its handle */
+  handle_id = new_con_handle_id ();
+  if (handle_id <= 0)
+    {
+      /* init_con_handle cleans up after itself, but not once it succeeded */
+      con_handle_content_free (con_handle);
+      goto error_end;
+    }
+
   con_handle->id = handle_id;
+  con_handle_segments[(handle_id - 1) / CON_HANDLE_SEGMENT_SIZE]->
+    handle[(handle_id - 1) % CON_HANDLE_SEGMENT_SIZE] = con_handle;
 
   return con_handle;
 
@@ -264,7 +570,7 @@ hm_con_handle_free (T_CON_HANDLE * con_handle)
       return CCI_ER_CON_HANDLE;
     }
 
-  con_handle_table[con_handle->id - 1] = NULL;
+  free_con_handle_id (con_handle->id);
   if (!IS_INVALID_SOCKET (con_handle->sock_fd))
     {
       CLOSE_SOCKET (con_handle->sock_fd);
@@ -334,7 +640,7 @@ hm_pool_move_node_from_use_to_lru (T_CON_HANDLE * connection,
 {
   T_REQ_HANDLE *target;
 
-  statement_id = statement_id % CON_HANDLE_ID_FACTOR;
+  statement_id = statement_id % RESOLVED_ID_FACTOR;
   target = connection->req_handle_table[statement_id - 1];
   assert (target != NULL);
 
@@ -356,7 +662,7 @@ hm_pool_move_node_from_lru_to_use (T_CON_HANDLE * connection,
 {
   T_REQ_HANDLE *target;
 
-  statement_id = statement_id % CON_HANDLE_ID_FACTOR;
+  statement_id = statement_id % RESOLVED_ID_FACTOR;
   target = connection->req_handle_table[statement_id - 1];
   assert (target != NULL);
 
@@ -391,6 +697,63 @@ hm_pool_victimize_last_node_from_lru (T_CON_HANDLE * connection)
   return victim;
 }
 
+static void
+hm_pool_close_victim (T_CON_HANDLE * connection, T_REQ_HANDLE * victim)
+{
+  if (victim->handle_type == HANDLE_PREPARE
+      || victim->handle_type == HANDLE_SCHEMA_INFO)
+    {
+      /* because the statement will be terminated by restarting cas
+       * all errors of qe_close_req_handle() are ignored
+       */
+      qe_close_req_handle (victim, connection);
+    }
+  mht_rem (connection->stmt_pool, victim->sql_text, true, true);
+  hm_req_handle_free (connection, victim);
+}
+
+/*
+ * Resize the statement pool of a connection that has no datasource.
+ * Pooled statements beyond the new size are closed. With max_size 0 the
+ * pool is turned off and statements still in use are closed normally.
+ */
+int
+hm_pool_set_max_size (T_CON_HANDLE * connection, int max_size)
+{
+  T_REQ_HANDLE *r, *next;
+
+  connection->stmt_pool_max_size = max_size;
+
+  if (!DOES_CONNECTION_HAVE_STMT_POOL (connection))
+    {
+      for (r = connection->pool_use_head; r != NULL; r = next)
+	{
+	  next = r->next;
+	  r->prev = r->next = NULL;
+	}
+      connection->pool_use_head = NULL;
+      connection->pool_use_tail = NULL;
+
+      while (connection->pool_lru_head != NULL)
+	{
+	  hm_pool_close_victim (connection,
+				hm_pool_victimize_last_node_from_lru
+				(connection));
+	}
+      return CCI_ER_NO_ERROR;
+    }
+
+  while (connection->open_prepared_statement_count
+	 > STMT_POOL_MAX_SIZE (connection))
+    {
+      hm_pool_close_victim (connection,
+			    hm_pool_victimize_last_node_from_lru
+			    (connection));
+    }
+
+  return CCI_ER_NO_ERROR;
+}
+
 int
 hm_pool_restore_used_statements (T_CON_HANDLE * connection)
 {
@@ -417,7 +780,7 @@ hm_pool_add_statement_to_use (T_CON_HANDLE * connection, int statement_id)
 {
   T_REQ_HANDLE *statement;
 
-  statement_id = statement_id % CON_HANDLE_ID_FACTOR;
+  statement_id = statement_id % RESOLVED_ID_FACTOR;
   statement = connection->req_handle_table[statement_id - 1];
   assert (statement != NULL);
 
@@ -442,16 +805,17 @@ hm_req_handle_alloc (T_CON_HANDLE * con_handle,
       return (req_handle_id);
     }
 
-  req_handle = (T_REQ_HANDLE *) MALLOC (sizeof (T_REQ_HANDLE));
+  req_handle = req_handle_obj_alloc (con_handle);
   if (req_handle == NULL)
     {
+      free_req_handle_id (con_handle, req_handle_id);
       return CCI_ER_NO_MORE_MEMORY;
     }
 
   memset (req_handle, 0, sizeof (T_REQ_HANDLE));
   req_handle->req_handle_index = req_handle_id;
   req_handle->mapped_stmt_id = -1;
-  req_handle->fetch_size = 100;
+  req_handle->fetch_size = REQ_HANDLE_FETCH_SIZE_DEFAULT;
   req_handle->query_timeout = con_handle->query_timeout;
   req_handle->shard_id = CCI_SHARD_ID_INVALID;
   req_handle->is_fetch_completed = 0;
@@ -460,7 +824,7 @@ hm_req_handle_alloc (T_CON_HANDLE * con_handle,
   ++(con_handle->req_handle_count);
 
   *ret_req_handle = req_handle;
-  return MAKE_REQ_ID (con_handle->id, req_handle_id);
+  return MAKE_RESOLVED_REQ_ID (con_handle->id, req_handle_id);
 }
 
 int
@@ -480,18 +844,7 @@ hm_req_add_to_pool (T_CON_HANDLE * con, char *sql, int mapped_statement_id,
 
   if (HAS_REACHED_LIMIT_OPEN_STATEMENT (con))
     {
-      T_REQ_HANDLE *victim = hm_pool_victimize_last_node_from_lru (con);
-
-      if (victim->handle_type == HANDLE_PREPARE
-	  || victim->handle_type == HANDLE_SCHEMA_INFO)
-	{
-	  /* because the statement will be terminated by restarting cas
-	   * all errors of qe_close_req_handle() are ignored
-	   */
-	  qe_close_req_handle (victim, con);
-	}
-      mht_rem (con->stmt_pool, victim->sql_text, true, true);
-      hm_req_handle_free (con, victim);
+      hm_pool_close_victim (con, hm_pool_victimize_last_node_from_lru (con));
     }
 
   key = strdup (sql);
@@ -537,7 +890,7 @@ hm_req_get_from_pool (T_CON_HANDLE * con, T_REQ_HANDLE ** req, char *sql)
 
   if (req != NULL)
     {
-      *req = con->req_handle_table[GET_REQ_ID (req_id) - 1];
+      *req = con->req_handle_table[RESOLVED_REQ_ID (req_id) - 1];
     }
 
   return req_id;
@@ -546,13 +899,15 @@ hm_req_get_from_pool (T_CON_HANDLE * con, T_REQ_HANDLE ** req, char *sql)
 T_CCI_ERROR_CODE
 hm_get_connection_by_resolved_id (int resolved_id, T_CON_HANDLE ** connection)
 {
-  if (connection == NULL || con_handle_table[resolved_id - 1] == NULL)
+  T_CON_HANDLE *con_handle;
+
+  con_handle = con_handle_lookup (resolved_id);
+  if (connection == NULL || con_handle == NULL)
     {
       return CCI_ER_CON_HANDLE;
     }
 
-  *connection = con_handle_table[resolved_id - 1];
-  assert (*connection != NULL);
+  *connection = con_handle;
   return CCI_ER_NO_ERROR;
 }
 
@@ -574,12 +929,7 @@ hm_get_connection_internal (int mapped_id, T_CON_HANDLE ** connection,
     {
       return error;
     }
-  if (connection_id < 1 || connection_id > MAX_CON_HANDLE)
-    {
-      return CCI_ER_CON_HANDLE;
-    }
-
-  *connection = con_handle_table[connection_id - 1];
+  *connection = con_handle_lookup (connection_id);
   if (*connection == NULL)
     {
       return CCI_ER_CON_HANDLE;
@@ -626,14 +976,14 @@ hm_get_statement (int mapped_id, T_CON_HANDLE ** connection,
       return error;
     }
 
-  connection_id = GET_CON_ID (statement_id);
-  statement_id = GET_REQ_ID (statement_id);
+  connection_id = RESOLVED_CON_ID (statement_id);
+  statement_id = RESOLVED_REQ_ID (statement_id);
   if (connection_id < 1 || statement_id < 1)
     {
       return CCI_ER_REQ_HANDLE;
     }
 
-  conn = con_handle_table[connection_id - 1];
+  conn = con_handle_lookup (connection_id);
   if (conn == NULL)
     {
       return CCI_ER_REQ_HANDLE;
@@ -709,11 +1059,11 @@ hm_release_statement (int mapped_id, T_CON_HANDLE ** connection,
 void
 hm_req_handle_free (T_CON_HANDLE * con_handle, T_REQ_HANDLE * req_handle)
 {
-  con_handle->req_handle_table[req_handle->req_handle_index - 1] = NULL;
+  free_req_handle_id (con_handle, req_handle->req_handle_index);
   --(con_handle->req_handle_count);
 
   req_handle_content_free (req_handle, 0);
-  FREE_MEM (req_handle);
+  req_handle_obj_free (con_handle, req_handle);
 }
 
 void
@@ -722,7 +1072,8 @@ hm_req_handle_free_all (T_CON_HANDLE * con_handle)
   int i;
   T_REQ_HANDLE *req_handle = NULL;
 
-  for (i = 0; i < con_handle->max_req_handle; i++)
+  for (i = 0; i < con_handle->max_req_handle
+       && con_handle->req_handle_count > 0; i++)
     {
       req_handle = con_handle->req_handle_table[i];
       if (req_handle == NULL)
@@ -730,8 +1081,8 @@ hm_req_handle_free_all (T_CON_HANDLE * con_handle)
 	  continue;
 	}
       req_handle_content_free (req_handle, 0);
-      FREE_MEM (req_handle);
-      con_handle->req_handle_table[i] = NULL;
+      req_handle_obj_free (con_handle, req_handle);
+      free_req_handle_id (con_handle, i + 1);
       --(con_handle->req_handle_count);
     }
 }
@@ -755,8 +1106,8 @@ hm_req_handle_free_all_unholdable (T_CON_HANDLE * con_handle)
 	  continue;
 	}
       req_handle_content_free (req_handle, 0);
-      FREE_MEM (req_handle);
-      con_handle->req_handle_table[i] = NULL;
+      req_handle_obj_free (con_handle, req_handle);
+      free_req_handle_id (con_handle, i + 1);
       --(con_handle->req_handle_count);
     }
 }
@@ -833,10 +1184,14 @@ hm_req_handle_fetch_buf_free (T_REQ_HANDLE * req_handle)
 	}
       FREE_MEM (req_handle->tuple_value);
     }
-  FREE_MEM (req_handle->msg_buf);
+  FREE_MSG_BUF (req_handle->msg_buf);
   req_handle->fetched_tuple_begin = req_handle->fetched_tuple_end = 0;
   req_handle->cur_fetch_tuple_index = -1;
   req_handle->is_fetch_completed = 0;
+
+  /* an outstanding read-ahead reply is discarded when it arrives */
+  FREE_MSG_BUF (req_handle->read_ahead_msg);
+  req_handle->read_ahead_state = READ_AHEAD_NONE;
 }
 
 int
@@ -942,6 +1297,15 @@ req_handle_content_free_for_pool (T_REQ_HANDLE * req_handle)
 {
   req_close_query_result (req_handle);
   qe_bind_value_free (req_handle);
+
+  /* back to the unbound state of a fresh prepare, so that the next user
+   * of the statement never sends the previous one's parameters */
+  if (req_handle->bind_value != NULL)
+    {
+      memset (req_handle->bind_value, 0,
+	      sizeof (T_BIND_VALUE) * req_handle->num_bind);
+    }
+  req_handle->bind_array_size = 0;
 }
 
 int
@@ -971,8 +1335,8 @@ hm_find_host_status_index (unsigned char *ip_addr, int port)
 
   for (i = 0; i < host_status_count; i++)
     {
-      if (memcmp (host_status[i].host.ip_addr, ip_addr, 4) == 0
-	  && host_status[i].host.port == port)
+      if (memcmp (HOST_STATUS (i).host.ip_addr, ip_addr, 4) == 0
+	  && HOST_STATUS (i).host.port == port)
 	{
 	  index = i;
 	  break;
@@ -1013,7 +1377,7 @@ hm_is_host_reachable (T_CON_HANDLE * con_handle, int host_id)
   i = hm_find_host_status_index (ip_addr, port);
   if (i >= 0)
     {
-      is_reachable = host_status[i].is_reachable;
+      is_reachable = HOST_STATUS (i).is_reachable;
     }
 
   return is_reachable;
@@ -1032,6 +1396,141 @@ hm_set_host_status (T_CON_HANDLE * con_handle, int host_id, bool is_reachable)
     }
 }
 
+/*
+ * hm_host_connect_begin / hm_host_connect_end - bracket a connect to
+ *   alter_hosts[host_id]; connect_msec is the time the connect took, or
+ *   negative if it failed.
+ */
+void
+hm_host_connect_begin (T_CON_HANDLE * con_handle, int host_id)
+{
+  int i;
+
+  MUTEX_LOCK (host_status_mutex);
+  i = hm_add_host_status (con_handle->alter_hosts[host_id].ip_addr,
+			  con_handle->alter_hosts[host_id].port);
+  if (i >= 0)
+    {
+      HOST_STATUS (i).num_connecting++;
+    }
+  MUTEX_UNLOCK (host_status_mutex);
+}
+
+void
+hm_host_connect_end (T_CON_HANDLE * con_handle, int host_id,
+		     int connect_msec)
+{
+  int i;
+  T_HOST_STATUS *status;
+
+  MUTEX_LOCK (host_status_mutex);
+  i = hm_find_host_status_index (con_handle->alter_hosts[host_id].ip_addr,
+				 con_handle->alter_hosts[host_id].port);
+  if (i >= 0)
+    {
+      status = &HOST_STATUS (i);
+      status->num_connecting--;
+      if (connect_msec >= 0)
+	{
+	  status->is_reachable = true;
+	  status->connect_msec = (status->connect_msec < 0) ? connect_msec
+	    : (7 * status->connect_msec + connect_msec) / 8;
+	}
+    }
+  MUTEX_UNLOCK (host_status_mutex);
+}
+
+/*
+ * hm_host_cost - expected cost of connecting to alter_hosts[host_id]:
+ *   its smoothed latency weighted by the connects already in progress.
+ *   Hosts never measured cost the least, so they get tried.
+ *   Called with host_status_mutex held.
+ */
+static int
+hm_host_cost (T_CON_HANDLE * con_handle, int host_id)
+{
+  int i, latency = 0;
+  T_HOST_STATUS *status;
+
+  i = hm_find_host_status_index (con_handle->alter_hosts[host_id].ip_addr,
+				 con_handle->alter_hosts[host_id].port);
+  if (i < 0)
+    {
+      return 1;
+    }
+
+  status = &HOST_STATUS (i);
+  if (status->connect_msec >= 0)
+    {
+      latency = status->connect_msec;
+    }
+  else if (status->rtt_msec >= 0)
+    {
+      latency = status->rtt_msec;
+    }
+
+  return (latency + 1) * (status->num_connecting + 1);
+}
+
+/*
+ * hm_pick_alter_host - choose the host to connect to first when
+ *   loadBalance is set: of two reachable hosts drawn at random, the one
+ *   with the lower cost (power of two choices).
+ */
+int
+hm_pick_alter_host (T_CON_HANDLE * con_handle)
+{
+  int i, n = 0, a, b;
+  int reachable[ALTER_HOST_MAX_SIZE];
+  long int r;
+  struct timeval t;
+
+  for (i = 0; i < con_handle->alter_host_count; i++)
+    {
+      if (hm_is_host_reachable (con_handle, i))
+	{
+	  reachable[n++] = i;
+	}
+    }
+
+  if (n == 0)
+    {
+      return 0;
+    }
+  if (n == 1)
+    {
+      return reachable[0];
+    }
+
+  MUTEX_LOCK (host_status_mutex);
+
+  if (!host_pick_rand_seeded)
+    {
+      gettimeofday (&t, NULL);
+      srand48_r (t.tv_sec ^ t.tv_usec, &host_pick_rand);
+      host_pick_rand_seeded = true;
+    }
+
+  lrand48_r (&host_pick_rand, &r);
+  a = (int) (r % n);
+  lrand48_r (&host_pick_rand, &r);
+  b = (int) (r % (n - 1));
+  if (b >= a)
+    {
+      b++;
+    }
+  a = reachable[a];
+  b = reachable[b];
+
+  if (hm_host_cost (con_handle, b) < hm_host_cost (con_handle, a))
+    {
+      a = b;
+    }
+  MUTEX_UNLOCK (host_status_mutex);
+
+  return a;
+}
+
 void
 hm_set_con_handle_holdable (T_CON_HANDLE * con_handle, int holdable)
 {
@@ -1225,6 +1724,7 @@ init_con_handle (T_CON_HANDLE * con_handle, char *ip_str, int port,
 		 char *db_name, char *db_user, char *db_passwd)
 {
   unsigned char ip_addr[4];
+  int i;
 
   if (is_ip_str (ip_str))
     {
@@ -1261,8 +1761,13 @@ init_con_handle (T_CON_HANDLE * con_handle, char *ip_str, int port,
   con_handle->max_req_handle = REQ_HANDLE_ALLOC_SIZE;
   con_handle->req_handle_table = (T_REQ_HANDLE **)
     MALLOC (sizeof (T_REQ_HANDLE *) * con_handle->max_req_handle);
-  if (con_handle->req_handle_table == NULL)
+  con_handle->req_handle_next_free = (int *)
+    MALLOC (sizeof (int) * con_handle->max_req_handle);
+  if (con_handle->req_handle_table == NULL
+      || con_handle->req_handle_next_free == NULL)
     {
+      FREE_MEM (con_handle->req_handle_table);
+      FREE_MEM (con_handle->req_handle_next_free);
       FREE_MEM (con_handle->db_name);
       FREE_MEM (con_handle->db_user);
       FREE_MEM (con_handle->db_passwd);
@@ -1278,11 +1783,20 @@ init_con_handle (T_CON_HANDLE * con_handle, char *ip_str, int port,
       FREE_MEM (con_handle->db_user);
       FREE_MEM (con_handle->db_passwd);
       FREE_MEM (con_handle->req_handle_table);
+      FREE_MEM (con_handle->req_handle_next_free);
       return CCI_ER_NO_MORE_MEMORY;
     }
 
   memset (con_handle->req_handle_table,
 	  0, sizeof (T_REQ_HANDLE *) * con_handle->max_req_handle);
+  for (i = 0; i < con_handle->max_req_handle; i++)
+    {
+      con_handle->req_handle_next_free[i] =
+	(i + 1 < con_handle->max_req_handle) ? i + 2 : 0;
+    }
+  con_handle->req_handle_free_head = 1;
+  con_handle->req_handle_slabs = NULL;
+  con_handle->req_handle_spare = NULL;
   con_handle->req_handle_count = 0;
   con_handle->open_prepared_statement_count = 0;
   memset (con_handle->broker_info, 0, BROKER_INFO_SIZE);
@@ -1304,6 +1818,7 @@ init_con_handle (T_CON_HANDLE * con_handle, char *ip_str, int port,
   con_handle->login_timeout = 30000;
   con_handle->query_timeout = 0;
   con_handle->disconnect_on_query_timeout = false;
+  con_handle->defer_close_handles = false;
   con_handle->start_time.tv_sec = 0;
   con_handle->start_time.tv_usec = 0;
   con_handle->current_timeout = 0;
@@ -1334,20 +1849,108 @@ init_con_handle (T_CON_HANDLE * con_handle, char *ip_str, int port,
 static int
 new_con_handle_id ()
 {
-  int i;
+  T_CON_HANDLE_SEGMENT *segment;
+  int handle_id;
 
-  for (i = 0; i < MAX_CON_HANDLE; i++)
+  MUTEX_LOCK (con_handle_id_mutex);
+
+  if (con_handle_free_head == 0 && con_handle_segment_grow () < 0)
     {
-      con_handle_current_index =
-	(con_handle_current_index + 1) % MAX_CON_HANDLE;
+      MUTEX_UNLOCK (con_handle_id_mutex);
+      return CCI_ER_ALLOC_CON_HANDLE;
+    }
 
-      if (con_handle_table[con_handle_current_index] == NULL)
-	{
-	  return (con_handle_current_index + 1);
-	}
+  handle_id = con_handle_free_head;
+  segment = con_handle_segments[(handle_id - 1) / CON_HANDLE_SEGMENT_SIZE];
+  con_handle_free_head =
+    segment->next_free[(handle_id - 1) % CON_HANDLE_SEGMENT_SIZE];
+
+  MUTEX_UNLOCK (con_handle_id_mutex);
+
+  return handle_id;
+}
+
+static void
+free_con_handle_id (int handle_id)
+{
+  T_CON_HANDLE_SEGMENT *segment;
+  int slot = (handle_id - 1) % CON_HANDLE_SEGMENT_SIZE;
+
+  if (handle_id < 1 || handle_id > MAX_CON_HANDLE)
+    {
+      return;
+    }
+
+  MUTEX_LOCK (con_handle_id_mutex);
+
+  segment = con_handle_segments[(handle_id - 1) / CON_HANDLE_SEGMENT_SIZE];
+
+  /* a second free of the same id would link it into the list twice */
+  if (segment != NULL && segment->handle[slot] != NULL)
+    {
+      segment->handle[slot] = NULL;
+      segment->next_free[slot] = con_handle_free_head;
+      con_handle_free_head = handle_id;
+    }
+
+  MUTEX_UNLOCK (con_handle_id_mutex);
+}
+
+/* called with con_handle_id_mutex held and an empty free list */
+static int
+con_handle_segment_grow ()
+{
+  T_CON_HANDLE_SEGMENT *segment;
+  int first_id, last_id, id;
+
+  if (con_handle_segment_count >= CON_HANDLE_SEGMENT_MAX)
+    {
+      return CCI_ER_ALLOC_CON_HANDLE;
+    }
+
+  segment = (T_CON_HANDLE_SEGMENT *) MALLOC (sizeof (T_CON_HANDLE_SEGMENT));
+  if (segment == NULL)
+    {
+      return CCI_ER_NO_MORE_MEMORY;
+    }
+  memset (segment, 0, sizeof (T_CON_HANDLE_SEGMENT));
+
+  first_id = con_handle_segment_count * CON_HANDLE_SEGMENT_SIZE + 1;
+  last_id = first_id + CON_HANDLE_SEGMENT_SIZE - 1;
+  if (last_id > MAX_CON_HANDLE)
+    {
+      last_id = MAX_CON_HANDLE;
+    }
+
+  /* hand out the lowest ids first */
+  for (id = last_id; id >= first_id; id--)
+    {
+      segment->next_free[id - first_id] = con_handle_free_head;
+      con_handle_free_head = id;
     }
 
-  return CCI_ER_ALLOC_CON_HANDLE;
+  con_handle_segments[con_handle_segment_count++] = segment;
+
+  return 0;
+}
+
+static T_CON_HANDLE *
+con_handle_lookup (int handle_id)
+{
+  T_CON_HANDLE_SEGMENT *segment;
+
+  if (handle_id < 1 || handle_id > MAX_CON_HANDLE)
+    {
+      return NULL;
+    }
+
+  segment = con_handle_segments[(handle_id - 1) / CON_HANDLE_SEGMENT_SIZE];
+  if (segment == NULL)
+    {
+      return NULL;
+    }
+
+  return segment->handle[(handle_id - 1) % CON_HANDLE_SEGMENT_SIZE];
 }
 
 static int
@@ -1357,16 +1960,27 @@ new_req_handle_id (T_CON_HANDLE * con_handle)
   int handle_id = 0;
   int new_max_req_handle;
   T_REQ_HANDLE **new_req_handle_table = NULL;
+  int *new_next_free = NULL;
 
-  for (i = 0; i < con_handle->max_req_handle; i++)
+  if (con_handle->req_handle_free_head > 0)
     {
-      if (con_handle->req_handle_table[i] == NULL)
-	{
-	  return (i + 1);
-	}
+      handle_id = con_handle->req_handle_free_head;
+      con_handle->req_handle_free_head =
+	con_handle->req_handle_next_free[handle_id - 1];
+      return handle_id;
+    }
+
+  /* the index must fit below RESOLVED_ID_FACTOR (MAKE_RESOLVED_REQ_ID) */
+  if (con_handle->max_req_handle >= RESOLVED_ID_FACTOR - 1)
+    {
+      return CCI_ER_REQ_HANDLE;
     }
 
-  new_max_req_handle = con_handle->max_req_handle + REQ_HANDLE_ALLOC_SIZE;
+  new_max_req_handle = con_handle->max_req_handle * 2;
+  if (new_max_req_handle > RESOLVED_ID_FACTOR - 1)
+    {
+      new_max_req_handle = RESOLVED_ID_FACTOR - 1;
+    }
   new_req_handle_table = (T_REQ_HANDLE **)
     REALLOC (con_handle->req_handle_table,
 	     sizeof (T_REQ_HANDLE *) * new_max_req_handle);
@@ -1374,18 +1988,85 @@ new_req_handle_id (T_CON_HANDLE * con_handle)
     {
       return CCI_ER_NO_MORE_MEMORY;
     }
+  con_handle->req_handle_table = new_req_handle_table;
 
-  handle_id = con_handle->max_req_handle + 1;
+  new_next_free = (int *) REALLOC (con_handle->req_handle_next_free,
+				   sizeof (int) * new_max_req_handle);
+  if (new_next_free == NULL)
+    {
+      return CCI_ER_NO_MORE_MEMORY;
+    }
+  con_handle->req_handle_next_free = new_next_free;
 
   memset (new_req_handle_table + con_handle->max_req_handle, 0,
-	  REQ_HANDLE_ALLOC_SIZE * sizeof (T_REQ_HANDLE *));
+	  (new_max_req_handle - con_handle->max_req_handle)
+	  * sizeof (T_REQ_HANDLE *));
+
+  /* the first new slot is returned, the rest go to the free list */
+  handle_id = con_handle->max_req_handle + 1;
+  for (i = handle_id; i < new_max_req_handle; i++)
+    {
+      new_next_free[i] = (i + 1 < new_max_req_handle) ? i + 2 : 0;
+    }
+  con_handle->req_handle_free_head =
+    (handle_id < new_max_req_handle) ? handle_id + 1 : 0;
 
   con_handle->max_req_handle = new_max_req_handle;
-  con_handle->req_handle_table = new_req_handle_table;
 
   return handle_id;
 }
 
+static void
+free_req_handle_id (T_CON_HANDLE * con_handle, int handle_id)
+{
+  con_handle->req_handle_table[handle_id - 1] = NULL;
+  con_handle->req_handle_next_free[handle_id - 1] =
+    con_handle->req_handle_free_head;
+  con_handle->req_handle_free_head = handle_id;
+}
+
+/*
+ * T_REQ_HANDLE objects are carved out of per-connection slabs and recycled
+ * through req_handle_spare; the slabs are released with the connection.
+ */
+static T_REQ_HANDLE *
+req_handle_obj_alloc (T_CON_HANDLE * con_handle)
+{
+  T_REQ_HANDLE_SLAB *slab;
+  T_REQ_HANDLE *req_handle;
+  int i;
+
+  if (con_handle->req_handle_spare == NULL)
+    {
+      slab = (T_REQ_HANDLE_SLAB *) MALLOC (sizeof (T_REQ_HANDLE_SLAB));
+      if (slab == NULL)
+	{
+	  return NULL;
+	}
+
+      slab->next = con_handle->req_handle_slabs;
+      con_handle->req_handle_slabs = slab;
+
+      for (i = REQ_HANDLE_SLAB_SIZE - 1; i >= 0; i--)
+	{
+	  slab->handles[i].next = con_handle->req_handle_spare;
+	  con_handle->req_handle_spare = &slab->handles[i];
+	}
+    }
+
+  req_handle = con_handle->req_handle_spare;
+  con_handle->req_handle_spare = (T_REQ_HANDLE *) req_handle->next;
+
+  return req_handle;
+}
+
+static void
+req_handle_obj_free (T_CON_HANDLE * con_handle, T_REQ_HANDLE * req_handle)
+{
+  req_handle->next = con_handle->req_handle_spare;
+  con_handle->req_handle_spare = req_handle;
+}
+
 static void
 con_handle_content_free (T_CON_HANDLE * con_handle)
 {
@@ -1394,6 +2075,15 @@ con_handle_content_free (T_CON_HANDLE * con_handle)
   FREE_MEM (con_handle->db_passwd);
   con_handle->url[0] = '\0';
   FREE_MEM (con_handle->req_handle_table);
+  FREE_MEM (con_handle->req_handle_next_free);
+  while (con_handle->req_handle_slabs != NULL)
+    {
+      T_REQ_HANDLE_SLAB *slab = con_handle->req_handle_slabs;
+
+      con_handle->req_handle_slabs = slab->next;
+      FREE_MEM (slab);
+    }
+  con_handle->req_handle_spare = NULL;
   FREE_MEM (con_handle->deferred_close_handle_list);
   FREE_MEM (con_handle->last_insert_id);
 
@@ -1402,6 +2092,9 @@ con_handle_content_free (T_CON_HANDLE * con_handle)
       mht_destroy (con_handle->stmt_pool, true, true);
     }
   FREE_MEM (con_handle->log_filename);
+  net_recv_arena_clear (&con_handle->recv_arena);
+  FREE_MEM (con_handle->sock_read_buf.buf);
+  net_buf_clear (&con_handle->send_buf);
 }
 
 static void
@@ -1442,6 +2135,52 @@ is_ip_str (char *ip_str)
   return 1;
 }
 
+/*
+ * hm_add_host_status - find the status of a broker, adding it when it is
+ *   not tracked yet. Called with host_status_mutex held; returns -1 if the
+ *   table is full.
+ */
+static int
+hm_add_host_status (unsigned char *ip_addr, int port)
+{
+  int i;
+
+  i = hm_find_host_status_index (ip_addr, port);
+  if (i >= 0)
+    {
+      return i;
+    }
+
+  i = host_status_count;
+  if (i % HOST_STATUS_SEGMENT_SIZE == 0)
+    {
+      if (i / HOST_STATUS_SEGMENT_SIZE >= HOST_STATUS_SEGMENT_MAX)
+	{
+	  return -1;
+	}
+
+      host_status_segments[i / HOST_STATUS_SEGMENT_SIZE] =
+	(T_HOST_STATUS *) MALLOC (sizeof (T_HOST_STATUS)
+				  * HOST_STATUS_SEGMENT_SIZE);
+      if (host_status_segments[i / HOST_STATUS_SEGMENT_SIZE] == NULL)
+	{
+	  return -1;
+	}
+    }
+
+  memcpy (HOST_STATUS (i).host.ip_addr, ip_addr, 4);
+  HOST_STATUS (i).host.port = port;
+  HOST_STATUS (i).is_reachable = true;
+  HOST_STATUS (i).rtt_msec = -1;
+  HOST_STATUS (i).connect_msec = -1;
+  HOST_STATUS (i).num_connecting = 0;
+  HOST_STATUS (i).probe_interval = MONITORING_INTERVAL;
+  HOST_STATUS (i).next_probe_time = time (NULL) + MONITORING_INTERVAL;
+  host_status_count++;
+
+  return i;
+}
+
 static void
 hm_set_host_status_by_addr (unsigned char *ip_addr, int port,
 			    bool is_reachable)
@@ -1449,47 +2188,124 @@ hm_set_host_status_by_addr (unsigned char *ip_addr, int port,
   int i;
 
   MUTEX_LOCK (host_status_mutex);
-  i = hm_find_host_status_index (ip_addr, port);
-
+  i = hm_add_host_status (ip_addr, port);
   if (i < 0)
     {
-      i = host_status_count;
-      memcpy (host_status[i].host.ip_addr, ip_addr, 4);
-      host_status[i].host.port = port;
-      host_status_count++;
+      /* untracked hosts are always considered reachable */
+      MUTEX_UNLOCK (host_status_mutex);
+      return;
     }
-  host_status[i].is_reachable = is_reachable;
+
+  if (HOST_STATUS (i).is_reachable && !is_reachable)
+    {
+      /* probe a host that just failed soon, then back off */
+      HOST_STATUS (i).probe_interval = HOST_PROBE_INTERVAL_MIN;
+      HOST_STATUS (i).next_probe_time = time (NULL) + HOST_PROBE_INTERVAL_MIN;
+    }
+  HOST_STATUS (i).is_reachable = is_reachable;
 
   MUTEX_UNLOCK (host_status_mutex);
 
 }
 
+static void
+hm_set_host_probe_result (T_ALTER_HOST * host, int rtt_msec, time_t now)
+{
+  int i;
+  T_HOST_STATUS *status;
+
+  MUTEX_LOCK (host_status_mutex);
+  i = hm_find_host_status_index (host->ip_addr, host->port);
+  if (i < 0)
+    {
+      MUTEX_UNLOCK (host_status_mutex);
+      return;
+    }
+  status = &HOST_STATUS (i);
+
+  if (rtt_msec >= 0)
+    {
+      status->is_reachable = true;
+      status->rtt_msec = (status->rtt_msec < 0) ? rtt_msec
+	: (3 * status->rtt_msec + rtt_msec) / 4;
+      status->probe_interval = MONITORING_INTERVAL;
+
+      /* a host that lost the balancing stops being measured by connects,
+       * so let its connect time recover towards the probe */
+      if (status->connect_msec > rtt_msec)
+	{
+	  status->connect_msec = (status->connect_msec + rtt_msec) / 2;
+	}
+    }
+  else if (status->is_reachable)
+    {
+      /* probe a host that just failed soon, then back off */
+      status->is_reachable = false;
+      status->rtt_msec = -1;
+      status->probe_interval = HOST_PROBE_INTERVAL_MIN;
+    }
+  else
+    {
+      status->rtt_msec = -1;
+      status->probe_interval = MIN (status->probe_interval * 2,
+				    MONITORING_INTERVAL);
+    }
+  status->next_probe_time = now + status->probe_interval;
+
+  MUTEX_UNLOCK (host_status_mutex);
+}
+
+/*
+ * hm_thread_health_checker - probe the known brokers that are due, all at
+ *   once. A host that went down is retried after HOST_PROBE_INTERVAL_MIN
+ *   seconds, doubling up to MONITORING_INTERVAL; reachable hosts are probed
+ *   every MONITORING_INTERVAL to keep their round trip time current.
+ */
 static THREAD_RET_T THREAD_CALLING_CONVENTION
 hm_thread_health_checker (void *arg)
 {
-  int i;
-  unsigned char *ip_addr;
-  int port;
-  time_t start_time;
-  time_t elapsed_time;
+  int i, count, capacity = 0;
+  time_t now;
+  T_BROKER_PROBE *probes = NULL, *tmp;
+
   while (1)
     {
-      start_time = time (NULL);
-      for (i = 0; i < host_status_count; i++)
+      now = time (NULL);
+      count = 0;
+
+      MUTEX_LOCK (host_status_mutex);
+      if (host_status_count > capacity)
 	{
-	  ip_addr = host_status[i].host.ip_addr;
-	  port = host_status[i].host.port;
-	  if (!host_status[i].is_reachable && net_check_broker_alive
-	      (ip_addr, port, BROKER_HEALTH_CHECK_TIMEOUT))
+	  tmp = (T_BROKER_PROBE *) REALLOC (probes, sizeof (T_BROKER_PROBE)
+					    * host_status_count);
+	  if (tmp != NULL)
 	    {
-	      hm_set_host_status_by_addr (ip_addr, port, true);
+	      probes = tmp;
+	      capacity = host_status_count;
 	    }
 	}
-      elapsed_time = time (NULL) - start_time;
-      if (elapsed_time < MONITORING_INTERVAL)
+      for (i = 0; i < host_status_count && count < capacity; i++)
 	{
-	  SLEEP_MILISEC (MONITORING_INTERVAL - elapsed_time, 0);
+	  if (HOST_STATUS (i).next_probe_time <= now)
+	    {
+	      probes[count++].host = HOST_STATUS (i).host;
+	    }
 	}
+      MUTEX_UNLOCK (host_status_mutex);
+
+      if (count > 0)
+	{
+	  net_probe_brokers (probes, count, BROKER_HEALTH_CHECK_TIMEOUT);
+
+	  now = time (NULL);
+	  for (i = 0; i < count; i++)
+	    {
+	      hm_set_host_probe_result (&probes[i].host, probes[i].rtt_msec,
+					now);
+	    }
+	}
+
+      SLEEP_MILISEC (HEALTH_CHECK_TICK, 0);
     }
   return (THREAD_RET_T) 0;
 }
@@ -60,6 +60,7 @@ extern "C"
 #include "cci_common.h"
 #include "cas_cci.h"
 #include "cas_protocol.h"
+#include "cci_net_buf.h"
 
 /************************************************************************
  * PUBLIC DEFINITIONS							*
@@ -79,10 +80,28 @@ extern "C"
 #define DEFERRED_CLOSE_HANDLE_ALLOC_SIZE        256
 #define MONITORING_INTERVAL		    	60
 
+#define REQ_HANDLE_FETCH_SIZE_DEFAULT		100
+
+#define BIND_VALUE_INLINE_SIZE			32	/* T_BIND_VALUE inline storage */
+
+/*
+ * Resolved statement ids pack the connection id above the statement
+ * index.  The public CON_HANDLE_ID_FACTOR would stop connection ids at
+ * 2147, so the library uses a smaller factor of its own.
+ */
+#define RESOLVED_ID_FACTOR			100000
+#define RESOLVED_CON_ID(H)			((H) / RESOLVED_ID_FACTOR)
+#define RESOLVED_REQ_ID(H)			((H) % RESOLVED_ID_FACTOR)
+#define MAKE_RESOLVED_REQ_ID(C,R)		((C) * RESOLVED_ID_FACTOR + (R))
+
 #define DOES_CONNECTION_HAVE_STMT_POOL(c) \
-  ((c)->datasource && (c)->datasource->pool_prepared_statement)
+  ((c)->stmt_pool_max_size > 0 \
+   || ((c)->datasource && (c)->datasource->pool_prepared_statement))
+#define STMT_POOL_MAX_SIZE(c) \
+  ((c)->stmt_pool_max_size > 0 ? (c)->stmt_pool_max_size \
+   : (c)->datasource->max_open_prepared_statement)
 #define HAS_REACHED_LIMIT_OPEN_STATEMENT(c) \
-  ((c)->open_prepared_statement_count >= (c)->datasource->max_open_prepared_statement)
+  ((c)->open_prepared_statement_count >= STMT_POOL_MAX_SIZE (c))
 /************************************************************************
  * PUBLIC TYPE DEFINITIONS						*
  ************************************************************************/
@@ -122,6 +141,32 @@ extern "C"
     char **decoded_ptr;
   } T_TUPLE_VALUE;
 
+  typedef enum
+  {
+    READ_AHEAD_NONE,
+    READ_AHEAD_SENT,		/* CAS_FC_FETCH sent, reply not received */
+    READ_AHEAD_RECEIVED		/* reply held in read_ahead_msg */
+  } T_READ_AHEAD_STATE;
+
+#define RECV_ARENA_MAX_FREE	4
+
+  /* reply buffers kept for reuse by the next net_recv_msg */
+  typedef struct
+  {
+    char *free_buf[RECV_ARENA_MAX_FREE];
+    int num_free;
+    int peak_size;		/* largest reply in the current window */
+    int num_recv;		/* replies received in the current window */
+  } T_RECV_ARENA;
+
+  /* bytes read from sock_fd ahead of the message being received */
+  typedef struct
+  {
+    char *buf;
+    int begin;
+    int end;
+  } T_SOCK_READ_BUF;
+
   typedef struct
   {
     T_CCI_U_TYPE u_type;
@@ -130,6 +175,16 @@ extern "C"
     void *value;
     int *null_ind;
     char flag;
+    union			/* small values, to save a malloc per bind */
+    {
+      int i;
+      INT64 bi;
+      float f;
+      double d;
+      T_CCI_DATE date;
+      T_OBJECT obj;
+      char str[BIND_VALUE_INLINE_SIZE];
+    } inline_value;
   } T_BIND_VALUE;
 
   typedef struct
@@ -159,6 +214,7 @@ extern "C"
     int bind_array_size;
     int num_col_info;
     int fetch_size;
+    int fetch_size_budget;	/* bytes per fetch, > 0 : adaptive fetch_size */
     char *msg_buf;
     int cursor_pos;
     int fetched_tuple_begin;
@@ -175,10 +231,24 @@ extern "C"
     int is_from_current_transaction;
     int shard_id;
     char is_fetch_completed;	/* used only cas4oracle */
+    char read_ahead;		/* prefetch the next tuple block */
+    char read_ahead_state;	/* T_READ_AHEAD_STATE */
+    int read_ahead_pos;		/* cursor_pos the prefetched block starts at */
+    char *read_ahead_msg;
+    int read_ahead_msg_size;
     void *prev;
     void *next;
   } T_REQ_HANDLE;
 
+#define REQ_HANDLE_SLAB_SIZE			16
+
+  typedef struct t_req_handle_slab T_REQ_HANDLE_SLAB;
+  struct t_req_handle_slab
+  {
+    T_REQ_HANDLE_SLAB *next;
+    T_REQ_HANDLE handles[REQ_HANDLE_SLAB_SIZE];
+  };
+
   typedef struct
   {
     T_REQ_HANDLE *req_handle;
@@ -212,6 +282,10 @@ extern "C"
     int max_req_handle;
     T_EXEC_THR_ARG thr_arg;
     T_REQ_HANDLE **req_handle_table;
+    int *req_handle_next_free;	/* free slots of req_handle_table */
+    int req_handle_free_head;	/* 1-based slot, 0 if none */
+    T_REQ_HANDLE_SLAB *req_handle_slabs;
+    T_REQ_HANDLE *req_handle_spare;	/* unused handles, chained by next */
     int req_handle_count;
     int open_prepared_statement_count;
     int cas_pid;
@@ -220,6 +294,7 @@ extern "C"
     int cas_id;
     T_CCI_SESSION_ID session_id;
     T_CCI_DATASOURCE *datasource;
+    int datasource_slot;	/* index in datasource->con_handles */
     MHT_TABLE *stmt_pool;
 
     /* HA */
@@ -241,9 +316,11 @@ extern "C"
     T_REQ_HANDLE *pool_lru_tail;
     T_REQ_HANDLE *pool_use_head;
     T_REQ_HANDLE *pool_use_tail;
+    int stmt_pool_max_size;	/* pool without a datasource, 0 if off */
     int login_timeout;
     int query_timeout;
     char disconnect_on_query_timeout;
+    char defer_close_handles;	/* defer result set closes as well */
     char *log_filename;
     char log_on_exception;
     char log_slow_queries;
@@ -265,6 +342,18 @@ extern "C"
 
     /* shard */
     int shard_id;
+
+    /* read-ahead fetch whose reply is still unread on sock_fd */
+    int read_ahead_req_index;	/* req_handle_index, 0 if none */
+    SOCKET read_ahead_sock_fd;
+
+    T_RECV_ARENA recv_arena;
+    T_SOCK_READ_BUF sock_read_buf;
+    T_NET_BUF send_buf;		/* request buffer kept for reuse */
+
+    /* idle connection pool (hm_put_con_to_pool) */
+    void *pool_idle_next;
+    time_t pool_idle_since;
   } T_CON_HANDLE;
 
 /************************************************************************
@@ -318,6 +407,8 @@ extern "C"
 					     char *dbname, char *dbuser,
 					     char *dbpasswd);
   extern int hm_put_con_to_pool (int con);
+  extern int hm_con_pool_set_limits (int max_idle_per_key, int idle_timeout);
+  extern void hm_con_pool_get_stats (T_CCI_CON_POOL_STATS * stats);
 
   extern T_BROKER_VERSION hm_get_broker_version (T_CON_HANDLE * con_handle);
   extern bool hm_broker_understand_renewed_error_code (T_CON_HANDLE *
@@ -348,10 +439,16 @@ extern "C"
   extern void hm_set_host_status (T_CON_HANDLE * con_handle, int host_id,
 				  bool is_reachable);
   extern bool hm_is_host_reachable (T_CON_HANDLE * con_handle, int host_id);
+  extern void hm_host_connect_begin (T_CON_HANDLE * con_handle,
+				     int host_id);
+  extern void hm_host_connect_end (T_CON_HANDLE * con_handle, int host_id,
+				   int connect_msec);
+  extern int hm_pick_alter_host (T_CON_HANDLE * con_handle);
   extern void hm_check_rc_time (T_CON_HANDLE * con_handle);
   extern void hm_create_health_check_th (void);
 
   extern int hm_pool_restore_used_statements (T_CON_HANDLE * connection);
+  extern int hm_pool_set_max_size (T_CON_HANDLE * connection, int max_size);
   extern int hm_pool_add_statement_to_use (T_CON_HANDLE * connection,
 					   int statement_id);
 
@@ -31,260 +31,481 @@
 /*
  * cci_map.cpp
  */
+#include <string.h>
 
 #if defined(WINDOWS)
-#include <hash_map>
+#include <windows.h>
+#include <intrin.h>
 #else /* WINDOWS */
-#include <ext/hash_map>
+#include <sched.h>
 #endif /* WINDOWS */
-#include <map>
 
+#include "cci_common.h"
 #include "cci_handle_mng.h"
 #include "cas_cci.h"
-#include "cci_mutex.h"
 #include "cci_map.h"
 
+/*
+ * Public ids are looked up on every CCI call, so the tables below never
+ * take a lock on the lookup path.  An id packs the slot index (plus one)
+ * in the low MAP_SLOT_BITS bits and the slot generation above it; a slot
+ * holds its current id while in use and 0 while free, so a stale id
+ * simply fails to compare equal.  Slots live in segments that are
+ * allocated on demand and never freed.
+ *
+ * A slot whose generation would wrap is retired instead of freed, and
+ * the table grows past it; retired slots come back only once the table
+ * is full.  An id is thus reissued only after about 2^31 opens, as with
+ * a plain counter.
+ *
+ * A caller that goes on to touch the mapped handle pins the slot first;
+ * close waits for the pins to drain, so once a mapping is closed no
+ * lookup still holds a pointer to its handle and the handle may be freed.
+ */
+#define MAP_SLOT_BITS           18
+#define MAP_SLOT_MASK           ((1 << MAP_SLOT_BITS) - 1)
+#define MAP_SEGMENT_SIZE        4096
+#define MAP_SEGMENT_MAX         (MAP_SLOT_MASK / MAP_SEGMENT_SIZE)
+#define MAP_GENERATION_MASK     ((1 << (31 - MAP_SLOT_BITS)) - 1)
+#define MAP_SLOT_FREE           0
+#define MAP_SLOT_RESERVED       (-1)
+#define MAP_SLOT_RETIRED        (-2)
+
 #if defined(WINDOWS)
-typedef stdext::hash_map<T_CCI_CONN, T_CCI_CONN> MapConnection;
-typedef stdext::hash_map<T_CCI_REQ, T_CCI_REQ> MapStatement;
+#define MAP_CAS_INT(PTR, OLD, NEW) \
+  (InterlockedCompareExchange ((LONG volatile *) (PTR), (NEW), (OLD)) \
+   == (OLD))
+#define MAP_CAS_PTR(PTR, OLD, NEW) \
+  (InterlockedCompareExchangePointer ((PVOID volatile *) (PTR), (NEW), \
+                                      (OLD)) == (OLD))
+#define MAP_CAS_CHAR(PTR, OLD, NEW) \
+  (_InterlockedCompareExchange8 ((char volatile *) (PTR), (NEW), (OLD)) \
+   == (OLD))
+#define MAP_FETCH_ADD(PTR, VAL) \
+  ((unsigned int) InterlockedExchangeAdd ((LONG volatile *) (PTR), (VAL)))
+#define MAP_BARRIER()           MemoryBarrier ()
+#define MAP_YIELD()             SwitchToThread ()
 #else /* WINDOWS */
-typedef __gnu_cxx::hash_map<T_CCI_CONN, T_CCI_CONN> MapConnection;
-typedef __gnu_cxx::hash_map<T_CCI_REQ, T_CCI_REQ> MapStatement;
+#define MAP_CAS_INT(PTR, OLD, NEW) \
+  __sync_bool_compare_and_swap ((PTR), (OLD), (NEW))
+#define MAP_CAS_PTR(PTR, OLD, NEW) \
+  __sync_bool_compare_and_swap ((PTR), (OLD), (NEW))
+#define MAP_CAS_CHAR(PTR, OLD, NEW) \
+  __sync_bool_compare_and_swap ((PTR), (OLD), (NEW))
+#define MAP_FETCH_ADD(PTR, VAL) __sync_fetch_and_add ((PTR), (VAL))
+#define MAP_BARRIER()           __sync_synchronize ()
+#define MAP_YIELD()             sched_yield ()
 #endif /* WINDOWS */
 
-typedef MapConnection::iterator IteratorMapConnection;
-typedef MapStatement::iterator IteratorMapStatement;
+struct MapSlot
+{
+  volatile int id;		/* mapped id, MAP_SLOT_FREE, RESERVED or RETIRED */
+  int generation;		/* written only by the reserving thread */
+  int value;
+  volatile int pins;		/* lookups in progress on the handle */
+};
 
-static MapConnection mapConnection;
-static MapStatement mapStatement;
+class IdTable
+{
+public:
+  IdTable ():next_slot (0), num_segments (0)
+  {
+    memset ((void *) segments, 0, sizeof (segments));
+  }
+
+  T_CCI_ERROR_CODE open (int value, int *mapped_id);
+  bool get (int mapped_id, int *value);
+  bool pin (int mapped_id, int *value);
+  void unpin (int mapped_id);
+  bool close (int mapped_id);
+
+private:
+  MapSlot *get_slot (int index);
+  bool add_segment (int segment);
+  bool revive_slots (void);
+
+  volatile unsigned int next_slot;
+  volatile int num_segments;
+  MapSlot *volatile segments[MAP_SEGMENT_MAX];
+};
+
+MapSlot *
+IdTable::get_slot (int index)
+{
+  MapSlot *segment;
 
-static T_CCI_CONN currConnection = 0;
-static T_CCI_REQ currStatement = 0;
+  if (index < 0 || index >= MAP_SEGMENT_MAX * MAP_SEGMENT_SIZE)
+    {
+      return NULL;
+    }
 
-static cci::_Mutex mutexConnection;
-static cci::_Mutex mutexStatement;
+  segment = segments[index / MAP_SEGMENT_SIZE];
+  if (segment == NULL)
+    {
+      return NULL;
+    }
 
-template<class Map, class Value>
-static Value
-map_get_next_id (Map &map, Value &currValue)
+  return &segment[index % MAP_SEGMENT_SIZE];
+}
+
+bool
+IdTable::add_segment (int segment)
 {
-  do
+  MapSlot *slots;
+
+  if (segment >= MAP_SEGMENT_MAX)
+    {
+      return false;
+    }
+
+  if (segments[segment] == NULL)
     {
-      currValue ++;
-      if (currValue < 0)
+      slots = (MapSlot *) CALLOC (MAP_SEGMENT_SIZE, sizeof (MapSlot));
+      if (slots == NULL)
 	{
-	  currValue = 1;
+	  return false;
+	}
+
+      if (!MAP_CAS_PTR (&segments[segment], (MapSlot *) NULL, slots))
+	{
+	  FREE_MEM (slots);
 	}
     }
-  while (map.find (currValue) != map.end ());
 
-  return currValue;
+  /* publish the segment only after its pointer is visible */
+  MAP_CAS_INT (&num_segments, segment, segment + 1);
+
+  return true;
 }
 
-T_CCI_ERROR_CODE map_open_otc (T_CCI_CONN connection_id,
-                               T_CCI_CONN *mapped_conn_id)
+T_CCI_ERROR_CODE
+IdTable::open (int value, int *mapped_id)
 {
-  T_CCI_ERROR_CODE error;
+  MapSlot *slot;
+  int num_slots, index, id, i;
 
-  if (mapped_conn_id == NULL)
+  while (true)
     {
-      return CCI_ER_CON_HANDLE;
+      num_slots = num_segments * MAP_SEGMENT_SIZE;
+
+      for (i = 0; i < num_slots; i++)
+	{
+	  index = (int) (MAP_FETCH_ADD (&next_slot, 1) % num_slots);
+	  slot = get_slot (index);
+
+	  if (slot->id != MAP_SLOT_FREE
+	      || !MAP_CAS_INT (&slot->id, MAP_SLOT_FREE, MAP_SLOT_RESERVED))
+	    {
+	      continue;
+	    }
+
+	  id = (slot->generation << MAP_SLOT_BITS) | (index + 1);
+	  slot->value = value;
+
+	  MAP_BARRIER ();
+	  slot->id = id;
+
+	  *mapped_id = id;
+	  return CCI_ER_NO_ERROR;
+	}
+
+      if (!add_segment (num_slots / MAP_SEGMENT_SIZE) && !revive_slots ())
+	{
+	  return CCI_ER_NO_MORE_MEMORY;
+	}
     }
-  else
+}
+
+/* free every retired slot; called once the table cannot grow */
+bool
+IdTable::revive_slots (void)
+{
+  MapSlot *slot;
+  int num_slots, i;
+  bool revived = false;
+
+  num_slots = num_segments * MAP_SEGMENT_SIZE;
+  for (i = 0; i < num_slots; i++)
     {
-      *mapped_conn_id = -1;
-      error = CCI_ER_NO_ERROR;
+      slot = get_slot (i);
+      if (slot->id == MAP_SLOT_RETIRED
+	  && MAP_CAS_INT (&slot->id, MAP_SLOT_RETIRED, MAP_SLOT_FREE))
+	{
+	  revived = true;
+	}
     }
 
-  mutexConnection.lock ();
+  return revived;
+}
+
+bool
+IdTable::get (int mapped_id, int *value)
+{
+  MapSlot *slot;
+  int v;
+
+  if (mapped_id <= 0)
+    {
+      return false;
+    }
 
-  *mapped_conn_id = map_get_next_id (mapConnection, currConnection);
-  mapConnection[*mapped_conn_id] = connection_id;
+  slot = get_slot ((mapped_id & MAP_SLOT_MASK) - 1);
+  if (slot == NULL || slot->id != mapped_id)
+    {
+      return false;
+    }
 
-  mutexConnection.unlock ();
+  MAP_BARRIER ();
+  v = slot->value;
+  MAP_BARRIER ();
 
-  return error;
+  /* the slot was closed and reused while we were reading it */
+  if (slot->id != mapped_id)
+    {
+      return false;
+    }
+
+  *value = v;
+  return true;
 }
 
-T_CCI_ERROR_CODE map_get_otc_value (T_CCI_CONN mapped_conn_id,
-                                    T_CCI_CONN *connection_id,
-                                    bool force)
+bool
+IdTable::pin (int mapped_id, int *value)
 {
-  T_CCI_ERROR_CODE error;
+  MapSlot *slot;
 
-  if (connection_id == NULL)
+  if (mapped_id <= 0)
     {
-      return CCI_ER_CON_HANDLE;
+      return false;
     }
 
-  mutexConnection.lock ();
+  slot = get_slot ((mapped_id & MAP_SLOT_MASK) - 1);
+  if (slot == NULL)
+    {
+      return false;
+    }
 
-  IteratorMapConnection it = mapConnection.find (mapped_conn_id);
-  if (it == mapConnection.end ())
+  /* the increment is a full barrier, so close either sees the pin or
+   * get sees the closed slot */
+  MAP_FETCH_ADD (&slot->pins, 1);
+  if (!get (mapped_id, value))
     {
-      error = CCI_ER_CON_HANDLE;
+      MAP_FETCH_ADD (&slot->pins, -1);
+      return false;
     }
-  else
+
+  return true;
+}
+
+void
+IdTable::unpin (int mapped_id)
+{
+  MapSlot *slot;
+
+  slot = get_slot ((mapped_id & MAP_SLOT_MASK) - 1);
+  MAP_FETCH_ADD (&slot->pins, -1);
+}
+
+bool
+IdTable::close (int mapped_id)
+{
+  MapSlot *slot;
+
+  if (mapped_id <= 0)
     {
-      *connection_id = it->second;
-      error = CCI_ER_NO_ERROR;
+      return false;
+    }
 
-      if (force == false)
-	{
-	  T_CON_HANDLE *connection;
+  slot = get_slot ((mapped_id & MAP_SLOT_MASK) - 1);
+  if (slot == NULL
+      || !MAP_CAS_INT (&slot->id, mapped_id, MAP_SLOT_RESERVED))
+    {
+      return false;
+    }
 
-	  error = hm_get_connection_by_resolved_id (*connection_id,
-	                                            &connection);
-	  if (error == CCI_ER_NO_ERROR)
-	    {
-	      if (connection->used)
-		{
-		  error = CCI_ER_USED_CONNECTION;
-		}
-	      else
-		{
-		  connection->used = true;
-		}
-	    }
-	}
+  while (slot->pins != 0)
+    {
+      MAP_YIELD ();
     }
 
-  mutexConnection.unlock ();
+  slot->generation = (slot->generation + 1) & MAP_GENERATION_MASK;
 
-  return error;
+  MAP_BARRIER ();
+  slot->id = (slot->generation == 0 ? MAP_SLOT_RETIRED : MAP_SLOT_FREE);
+
+  return true;
 }
 
-T_CCI_ERROR_CODE map_close_otc (T_CCI_CONN mapped_conn_id)
+static IdTable tableConnection;
+static IdTable tableStatement;
+
+/*
+ * Resolve mapped_id in table and claim the used flag of its connection.
+ * The flag may be won just as the mapping is closed and the handle goes
+ * back to a pool, so the mapping is checked again and the claim undone
+ * if it no longer holds.
+ */
+static T_CCI_ERROR_CODE
+map_acquire_connection (IdTable & table, int mapped_id, int *value,
+			bool is_statement)
 {
   T_CCI_ERROR_CODE error;
-  int i;
+  T_CCI_ERROR_CODE not_found;
+  T_CON_HANDLE *connection;
+  int connection_id, v;
 
-  mutexConnection.lock ();
+  not_found = (is_statement ? CCI_ER_REQ_HANDLE : CCI_ER_CON_HANDLE);
 
-  IteratorMapConnection it = mapConnection.find (mapped_conn_id);
-  if (it == mapConnection.end())
+  if (!table.pin (mapped_id, value))
     {
-      error = CCI_ER_CON_HANDLE;
+      return not_found;
     }
-  else
-    {
-      T_CON_HANDLE *connection;
-      T_REQ_HANDLE **statement_array;
 
-      error = hm_get_connection_by_resolved_id (it->second, &connection);
-      if (error == CCI_ER_NO_ERROR && connection != NULL)
+  connection_id = (is_statement ? RESOLVED_CON_ID (*value) : *value);
+  error = hm_get_connection_by_resolved_id (connection_id, &connection);
+  if (error == CCI_ER_NO_ERROR)
+    {
+      if (!MAP_CAS_CHAR (&connection->used, (char) false, (char) true))
 	{
-	  statement_array = connection->req_handle_table;
-	  for (i = 0; statement_array && i < connection->max_req_handle; i++)
-	    {
-	      if (statement_array[i] != NULL
-		  && statement_array[i]->mapped_stmt_id >= 0)
-		{
-		  map_close_ots (statement_array[i]->mapped_stmt_id);
-		}
-	    }
+	  error = CCI_ER_USED_CONNECTION;
+	}
+      else if (!table.get (mapped_id, &v) || v != *value)
+	{
+	  MAP_BARRIER ();
+	  connection->used = false;
+	  error = not_found;
 	}
-
-      mapConnection.erase(it);
-      error = CCI_ER_NO_ERROR;
     }
 
-
-  mutexConnection.unlock ();
+  table.unpin (mapped_id);
 
   return error;
 }
 
-T_CCI_ERROR_CODE map_open_ots (T_CCI_REQ statement_id,
-                               T_CCI_REQ *mapped_stmt_id)
+T_CCI_ERROR_CODE map_open_otc (T_CCI_CONN connection_id,
+                               T_CCI_CONN *mapped_conn_id)
 {
-
-  if (mapped_stmt_id == NULL)
+  if (mapped_conn_id == NULL)
     {
-      return CCI_ER_REQ_HANDLE;
+      return CCI_ER_CON_HANDLE;
     }
   else
     {
-      *mapped_stmt_id = -1;
+      *mapped_conn_id = -1;
     }
 
-  mutexStatement.lock ();
+  return tableConnection.open (connection_id, mapped_conn_id);
+}
 
-  *mapped_stmt_id = map_get_next_id (mapStatement, currStatement);
-  mapStatement[*mapped_stmt_id] = statement_id;
+T_CCI_ERROR_CODE map_get_otc_value (T_CCI_CONN mapped_conn_id,
+                                    T_CCI_CONN *connection_id,
+                                    bool force)
+{
+  if (connection_id == NULL)
+    {
+      return CCI_ER_CON_HANDLE;
+    }
 
-  mutexStatement.unlock ();
+  if (force == false)
+    {
+      return map_acquire_connection (tableConnection, mapped_conn_id,
+				     connection_id, false);
+    }
+
+  if (!tableConnection.get (mapped_conn_id, connection_id))
+    {
+      return CCI_ER_CON_HANDLE;
+    }
 
   return CCI_ER_NO_ERROR;
 }
 
-T_CCI_ERROR_CODE map_get_ots_value (T_CCI_REQ mapped_stmt_id,
-                                    T_CCI_REQ *statement_id,
-                                    bool force)
+T_CCI_ERROR_CODE map_close_otc (T_CCI_CONN mapped_conn_id)
 {
+  T_CCI_CONN connection_id;
+  T_CON_HANDLE *connection;
+  T_REQ_HANDLE **statement_array;
   T_CCI_ERROR_CODE error;
+  int i, count;
 
-  if (statement_id == NULL)
+  if (!tableConnection.get (mapped_conn_id, &connection_id))
     {
-      return CCI_ER_REQ_HANDLE;
+      return CCI_ER_CON_HANDLE;
     }
 
-  mutexStatement.lock ();
-
-  IteratorMapStatement it = mapStatement.find (mapped_stmt_id);
-  if (it == mapStatement.end ())
-    {
-      error = CCI_ER_REQ_HANDLE;
-    }
-  else
+  error = hm_get_connection_by_resolved_id (connection_id, &connection);
+  if (error == CCI_ER_NO_ERROR && connection != NULL)
     {
-      *statement_id = it->second;
-      error = CCI_ER_NO_ERROR;
-
-      if (force == false)
+      statement_array = connection->req_handle_table;
+      count = 0;
+      for (i = 0; statement_array && i < connection->max_req_handle
+	   && count < connection->req_handle_count; i++)
 	{
-	  T_CON_HANDLE *connection;
-	  T_CCI_CONN connection_id = GET_CON_ID (*statement_id);
+	  if (statement_array[i] == NULL)
+	    {
+	      continue;
+	    }
 
-	  error = hm_get_connection_by_resolved_id (connection_id,
-	                                            &connection);
-	  if (error == CCI_ER_NO_ERROR)
+	  count++;
+	  if (statement_array[i]->mapped_stmt_id >= 0)
 	    {
-	      if (connection->used)
-		{
-		  error = CCI_ER_USED_CONNECTION;
-		}
-	      else
-		{
-		  connection->used = true;
-		}
+	      map_close_ots (statement_array[i]->mapped_stmt_id);
 	    }
 	}
     }
 
-  mutexStatement.unlock ();
+  if (!tableConnection.close (mapped_conn_id))
+    {
+      return CCI_ER_CON_HANDLE;
+    }
 
-  return error;
+  return CCI_ER_NO_ERROR;
 }
 
-T_CCI_ERROR_CODE map_close_ots (T_CCI_REQ mapped_stmt_id)
+T_CCI_ERROR_CODE map_open_ots (T_CCI_REQ statement_id,
+                               T_CCI_REQ *mapped_stmt_id)
 {
-  T_CCI_ERROR_CODE error;
+  if (mapped_stmt_id == NULL)
+    {
+      return CCI_ER_REQ_HANDLE;
+    }
+  else
+    {
+      *mapped_stmt_id = -1;
+    }
 
-  mutexStatement.lock ();
+  return tableStatement.open (statement_id, mapped_stmt_id);
+}
 
-  IteratorMapStatement it = mapStatement.find (mapped_stmt_id);
-  if (it == mapStatement.end ())
+T_CCI_ERROR_CODE map_get_ots_value (T_CCI_REQ mapped_stmt_id,
+                                    T_CCI_REQ *statement_id,
+                                    bool force)
+{
+  if (statement_id == NULL)
     {
-      error = CCI_ER_REQ_HANDLE;
+      return CCI_ER_REQ_HANDLE;
     }
-  else
+
+  if (force == false)
+    {
+      return map_acquire_connection (tableStatement, mapped_stmt_id,
+				     statement_id, true);
+    }
+
+  if (!tableStatement.get (mapped_stmt_id, statement_id))
     {
-      mapStatement.erase(it);
-      error = CCI_ER_NO_ERROR;
+      return CCI_ER_REQ_HANDLE;
     }
 
-  mutexStatement.unlock ();
+  return CCI_ER_NO_ERROR;
+}
 
-  return error;
+T_CCI_ERROR_CODE map_close_ots (T_CCI_REQ mapped_stmt_id)
+{
+  if (!tableStatement.close (mapped_stmt_id))
+    {
+      return CCI_ER_REQ_HANDLE;
+    }
+
+  return CCI_ER_NO_ERROR;
 }
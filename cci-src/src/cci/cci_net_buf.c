@@ -71,6 +71,7 @@
  ************************************************************************/
 
 static int net_buf_realloc (T_NET_BUF * net_buf, int size);
+static int net_buf_resize (T_NET_BUF * net_buf, int new_alloc_size);
 
 /************************************************************************
  * INTERFACE VARIABLES							*
@@ -108,6 +109,58 @@ cnet_buf_clear (T_NET_BUF * net_buf)
   net_buf_init (net_buf);
 }
 
+/*
+ * net_buf_reserve - make room for size_hint more bytes at once, so the
+ *   encoder of a large message does not grow the buffer piece by piece.
+ */
+int
+cnet_buf_reserve (T_NET_BUF * net_buf, int size_hint)
+{
+  if (size_hint <= 0
+      || net_buf->data_size + size_hint <= net_buf->alloc_size)
+    {
+      return 0;
+    }
+
+  return net_buf_resize (net_buf, net_buf->data_size + size_hint);
+}
+
+/*
+ * net_buf_init_spare - initialize net_buf taking over the memory of spare,
+ *   if any. spare is left empty until net_buf_clear_spare gives it back.
+ */
+void
+cnet_buf_init_spare (T_NET_BUF * net_buf, T_NET_BUF * spare)
+{
+  *net_buf = *spare;
+  net_buf->data_size = 0;
+  net_buf->err_code = 0;
+  net_buf_init (spare);
+}
+
+/*
+ * net_buf_clear_spare - like net_buf_clear, but keep the memory in spare
+ *   for the next message instead of freeing it. Buffers larger than
+ *   NET_BUF_MAX_SPARE_SIZE are freed so that one huge request does not
+ *   pin its memory for the life of the connection.
+ */
+void
+cnet_buf_clear_spare (T_NET_BUF * net_buf, T_NET_BUF * spare)
+{
+  if (spare->data == NULL && net_buf->data != NULL
+      && net_buf->alloc_size <= NET_BUF_MAX_SPARE_SIZE)
+    {
+      *spare = *net_buf;
+      spare->data_size = 0;
+      spare->err_code = 0;
+      net_buf_init (net_buf);
+    }
+  else
+    {
+      net_buf_clear (net_buf);
+    }
+}
+
 int
 cnet_buf_cp_str (T_NET_BUF * net_buf, const char *buf, int size)
 {
@@ -266,21 +319,39 @@ net_buf_realloc (T_NET_BUF * net_buf, int size)
 
   if (size + net_buf->data_size > net_buf->alloc_size)
     {
-      new_alloc_size = net_buf->alloc_size + 1024;
-      if (size + net_buf->data_size > new_alloc_size)
+      /* grow geometrically so that encoding a large message costs
+       * a logarithmic number of reallocs instead of one per 1K */
+      new_alloc_size = net_buf->alloc_size * 2;
+      if (new_alloc_size < NET_BUF_MIN_ALLOC_SIZE)
 	{
-	  new_alloc_size = size + net_buf->data_size;
+	  new_alloc_size = NET_BUF_MIN_ALLOC_SIZE;
 	}
-      net_buf->data = (char *) REALLOC (net_buf->data, new_alloc_size);
-      if (net_buf->data == NULL)
+      if (size + net_buf->data_size > new_alloc_size)
 	{
-	  net_buf->alloc_size = 0;
-	  net_buf->err_code = CCI_ER_NO_MORE_MEMORY;
-	  return -1;
+	  new_alloc_size = size + net_buf->data_size;
 	}
+      return net_buf_resize (net_buf, new_alloc_size);
+    }
+
+  return 0;
+}
 
-      net_buf->alloc_size = new_alloc_size;
+static int
+net_buf_resize (T_NET_BUF * net_buf, int new_alloc_size)
+{
+  char *new_data;
+
+  new_data = (char *) REALLOC (net_buf->data, new_alloc_size);
+  if (new_data == NULL)
+    {
+      FREE_MEM (net_buf->data);
+      net_buf->alloc_size = 0;
+      net_buf->data_size = 0;
+      net_buf->err_code = CCI_ER_NO_MORE_MEMORY;
+      return -1;
     }
 
+  net_buf->data = new_data;
+  net_buf->alloc_size = new_alloc_size;
   return 0;
 }
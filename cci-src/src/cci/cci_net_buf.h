@@ -90,11 +90,17 @@
 #define NET_SIZE_TIMESTAMP	(NET_SIZE_SHORT * 6)
 #define NET_SIZE_DATETIME       (NET_SIZE_SHORT * 7)
 
+#define NET_BUF_MIN_ALLOC_SIZE	1024
+#define NET_BUF_MAX_SPARE_SIZE	(4 * 1024 * 1024)
+
 /*
  *  change function names to avoid naming conflict with cas server.
   */
 #define net_buf_init		cnet_buf_init
 #define net_buf_clear		cnet_buf_clear
+#define net_buf_reserve		cnet_buf_reserve
+#define net_buf_init_spare	cnet_buf_init_spare
+#define net_buf_clear_spare	cnet_buf_clear_spare
 #define net_buf_cp_str		cnet_buf_cp_str
 #define net_buf_cp_int		cnet_buf_cp_int
 #define net_buf_cp_bigint       cnet_buf_cp_bigint
@@ -125,6 +131,9 @@ typedef struct
 
 extern void cnet_buf_init (T_NET_BUF *);
 extern void cnet_buf_clear (T_NET_BUF *);
+extern int cnet_buf_reserve (T_NET_BUF *, int);
+extern void cnet_buf_init_spare (T_NET_BUF *, T_NET_BUF *);
+extern void cnet_buf_clear_spare (T_NET_BUF *, T_NET_BUF *);
 extern int cnet_buf_cp_str (T_NET_BUF *, const char *, int);
 extern int cnet_buf_cp_int (T_NET_BUF *, int);
 extern int cnet_buf_cp_bigint (T_NET_BUF *, INT64);
@@ -53,6 +53,7 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <poll.h>
 #endif
 
@@ -82,10 +83,48 @@
 
 #define SOCKET_TIMEOUT 5000	/* msec */
 
+/*
+ * Reply buffers handed out by net_recv_msg are preceded by a hidden header
+ * naming the arena they return to and their usable capacity.
+ */
+#define RECV_BUF_HEADER_SIZE	16
+#define RECV_BUF_ROUND_SIZE	4096
+#define RECV_ARENA_WINDOW	64	/* replies between shrink checks */
+
+#define SOCK_READ_BUF_SIZE	16384
+
+#define PROBE_BATCH_SIZE	64	/* brokers probed at the same time */
+
+#define RECV_BUF_HEADER(MSG)	\
+	((T_RECV_BUF_HEADER *) ((MSG) - RECV_BUF_HEADER_SIZE))
+
 /************************************************************************
  * PRIVATE TYPE DEFINITIONS						*
  ************************************************************************/
 
+typedef struct
+{
+  T_RECV_ARENA *arena;
+  int capacity;
+} T_RECV_BUF_HEADER;
+
+typedef enum
+{
+  PROBE_CONNECTING,
+  PROBE_RECV_PORT,
+  PROBE_RECV_HEADER,
+  PROBE_DONE
+} T_PROBE_STATE;
+
+typedef struct
+{
+  SOCKET sock_fd;
+  T_PROBE_STATE state;
+  char ready;
+  int received;
+  char buf[MSG_HEADER_SIZE];
+} T_PROBE_CONN;
+
 /************************************************************************
  * PRIVATE FUNCTION PROTOTYPES						*
  ************************************************************************/
@@ -98,12 +137,28 @@ static int net_send_int (SOCKET sock_fd, int value);
 static int net_recv_int (SOCKET sock_fd, int port, int *value);
 static int net_recv_stream (SOCKET sock_fd, int port, char *buf, int size,
 			    int timeout);
+static int net_wait_readable (SOCKET sock_fd, int port, int *timeout);
+static int net_recv_some (SOCKET sock_fd, int port, char *buf, int size,
+			  int *timeout);
+static int net_recv_con_stream (T_CON_HANDLE * con_handle, int port,
+				char *buf, int size, int timeout);
+static int net_recv_con_msg_header (T_CON_HANDLE * con_handle, int port,
+				    MSG_HEADER * header, int timeout);
 static int net_send_stream (SOCKET sock_fd, char *buf, int size);
+static int net_send_stream_vec (SOCKET sock_fd, char *buf1, int size1,
+				char *buf2, int size2);
 static void init_msg_header (MSG_HEADER * header);
-static int net_send_msg_header (SOCKET sock_fd, MSG_HEADER * header);
 static int net_recv_msg_header (SOCKET sock_fd, int port, MSG_HEADER * header,
 				int timeout);
 static bool net_peer_socket_alive (SOCKET sd, int port, int timeout_msec);
+static void make_health_check_msg (unsigned char *ip_addr, int port,
+				   char *client_info, char *db_info);
+static void probe_broker_batch (T_BROKER_PROBE * probes, int count,
+				int timeout_msec);
+static int probe_connect (T_ALTER_HOST * host, SOCKET * ret_sock);
+static int probe_wait (T_PROBE_CONN * conn, int count, int timeout_msec);
+static int probe_step (T_BROKER_PROBE * probe, T_PROBE_CONN * conn,
+		       struct timeval *start_time);
 static int net_cancel_request_internal (unsigned char *ip_addr, int port,
 					char *msg, int msglen);
 static int net_cancel_request_w_local_port (unsigned char *ip_addr, int port,
@@ -111,6 +166,8 @@ static int net_cancel_request_w_local_port (unsigned char *ip_addr, int port,
 					    unsigned short local_port);
 static int net_cancel_request_wo_local_port (unsigned char *ip_addr, int port,
 					     int pid);
+static char *net_recv_arena_alloc (T_RECV_ARENA * arena, int size);
+static void net_recv_arena_shrink (T_RECV_ARENA * arena);
 
 /************************************************************************
  * INTERFACE VARIABLES							*
@@ -402,6 +459,7 @@ net_connect_srv (T_CON_HANDLE * con_handle, int host_id,
   FREE_MEM (msg_buf);
 
   con_handle->sock_fd = srv_sock_fd;
+  con_handle->sock_read_buf.begin = con_handle->sock_read_buf.end = 0;
   con_handle->alter_host_id = host_id;
 
   if (con_handle->alter_host_count > 0)
@@ -590,45 +648,40 @@ net_send_msg (T_CON_HANDLE * con_handle, char *msg, int size)
   int err;
   struct timeval ts, te;
 
+  if (con_handle->read_ahead_req_index > 0)
+    {
+      /* the socket must be drained before the next request is sent */
+      net_recv_read_ahead (con_handle);
+      if (IS_INVALID_SOCKET (con_handle->sock_fd))
+	{
+	  return CCI_ER_COMMUNICATION;
+	}
+    }
+
   init_msg_header (&send_msg_header);
 
   *(send_msg_header.msg_body_size_ptr) = size;
   memcpy (send_msg_header.info_ptr, con_handle->cas_info,
 	  MSG_HEADER_INFO_SIZE);
 
-  /* send msg header */
-  if (con_handle->log_trace_network)
-    {
-      gettimeofday (&ts, NULL);
-    }
-  err = net_send_msg_header (con_handle->sock_fd, &send_msg_header);
-  if (con_handle->log_trace_network)
-    {
-      long elapsed;
-
-      gettimeofday (&te, NULL);
-      elapsed = ut_timeval_diff_msec (&ts, &te);
-      CCI_LOGF_DEBUG (con_handle->logger, "[NET][W][H][S:%d][E:%d][T:%d]",
-		      MSG_HEADER_SIZE, err, elapsed);
-    }
-  if (err < 0)
-    {
-      return CCI_ER_COMMUNICATION;
-    }
+  /* send msg header and body with one system call */
+  *(send_msg_header.msg_body_size_ptr) =
+    htonl (*(send_msg_header.msg_body_size_ptr));
 
   if (con_handle->log_trace_network)
     {
       gettimeofday (&ts, NULL);
     }
-  err = net_send_stream (con_handle->sock_fd, msg, size);
+  err = net_send_stream_vec (con_handle->sock_fd, send_msg_header.buf,
+			     MSG_HEADER_SIZE, msg, size);
   if (con_handle->log_trace_network)
     {
       long elapsed;
 
       gettimeofday (&te, NULL);
       elapsed = ut_timeval_diff_msec (&ts, &te);
-      CCI_LOGF_DEBUG (con_handle->logger, "[NET][W][B][S:%d][E:%d][T:%d]",
-		      size, err, elapsed);
+      CCI_LOGF_DEBUG (con_handle->logger, "[NET][W][HB][S:%d][E:%d][T:%d]",
+		      MSG_HEADER_SIZE + size, err, elapsed);
     }
   if (err < 0)
     {
@@ -692,8 +745,8 @@ net_recv_msg_timeout (T_CON_HANDLE * con_handle, char **msg, int *msg_size,
       gettimeofday (&ts, NULL);
     }
   result_code =
-    net_recv_msg_header (con_handle->sock_fd, broker_port,
-			 &recv_msg_header, timeout);
+    net_recv_con_msg_header (con_handle, broker_port, &recv_msg_header,
+			     timeout);
   if (con_handle->log_trace_network)
     {
       long elapsed;
@@ -713,8 +766,8 @@ net_recv_msg_timeout (T_CON_HANDLE * con_handle, char **msg, int *msg_size,
 	  if (con_handle->disconnect_on_query_timeout == false)
 	    {
 	      result_code =
-		net_recv_msg_header (con_handle->sock_fd, broker_port,
-				     &recv_msg_header, 0);
+		net_recv_con_msg_header (con_handle, broker_port,
+					 &recv_msg_header, 0);
 	    }
 	}
 
@@ -735,7 +788,8 @@ net_recv_msg_timeout (T_CON_HANDLE * con_handle, char **msg, int *msg_size,
 
   if (*(recv_msg_header.msg_body_size_ptr) > 0)
     {
-      tmp_p = (char *) MALLOC (*(recv_msg_header.msg_body_size_ptr));
+      tmp_p = net_recv_arena_alloc (&con_handle->recv_arena,
+				    *(recv_msg_header.msg_body_size_ptr));
       if (tmp_p == NULL)
 	{
 	  result_code = CCI_ER_NO_MORE_MEMORY;
@@ -746,9 +800,9 @@ net_recv_msg_timeout (T_CON_HANDLE * con_handle, char **msg, int *msg_size,
 	{
 	  gettimeofday (&ts, NULL);
 	}
-      result_code = net_recv_stream (con_handle->sock_fd, broker_port, tmp_p,
-				     *(recv_msg_header.msg_body_size_ptr),
-				     timeout);
+      result_code = net_recv_con_stream (con_handle, broker_port, tmp_p,
+					 *(recv_msg_header.msg_body_size_ptr),
+					 timeout);
       if (con_handle->log_trace_network)
 	{
 	  long elapsed;
@@ -803,7 +857,7 @@ net_recv_msg_timeout (T_CON_HANDLE * con_handle, char **msg, int *msg_size,
 		}
 	      err_code = CCI_ER_DBMS;
 	    }
-	  FREE_MEM (tmp_p);
+	  FREE_MSG_BUF (tmp_p);
 	  return err_code;
 	}
     }
@@ -814,7 +868,7 @@ net_recv_msg_timeout (T_CON_HANDLE * con_handle, char **msg, int *msg_size,
     }
   else
     {
-      FREE_MEM (tmp_p);
+      FREE_MSG_BUF (tmp_p);
     }
 
   if (msg_size)
@@ -825,9 +879,10 @@ net_recv_msg_timeout (T_CON_HANDLE * con_handle, char **msg, int *msg_size,
   return result_code;
 
 error_return:
-  FREE_MEM (tmp_p);
+  FREE_MSG_BUF (tmp_p);
   CLOSE_SOCKET (con_handle->sock_fd);
   con_handle->sock_fd = INVALID_SOCKET;
+  con_handle->sock_read_buf.begin = con_handle->sock_read_buf.end = 0;
 
   return result_code;
 }
@@ -839,6 +894,204 @@ net_recv_msg (T_CON_HANDLE * con_handle, char **msg, int *msg_size,
   return net_recv_msg_timeout (con_handle, msg, msg_size, err_buf, 0);
 }
 
+/*
+ * Receive the reply of the outstanding read-ahead fetch, if any, and hand
+ * it to the request handle that sent it. The reply is dropped when that
+ * handle has been freed or has moved to another result since.
+ */
+int
+net_recv_read_ahead (T_CON_HANDLE * con_handle)
+{
+  T_REQ_HANDLE *req_handle = NULL;
+  char *msg = NULL;
+  int msg_size = 0;
+  int index;
+  int err_code = 0;
+
+  index = con_handle->read_ahead_req_index;
+  if (index <= 0)
+    {
+      return 0;
+    }
+  con_handle->read_ahead_req_index = 0;
+
+  if (index <= con_handle->max_req_handle)
+    {
+      req_handle = con_handle->req_handle_table[index - 1];
+    }
+
+  /* a reconnected socket does not carry the reply */
+  if (con_handle->read_ahead_sock_fd == con_handle->sock_fd
+      && !IS_INVALID_SOCKET (con_handle->sock_fd))
+    {
+      err_code = net_recv_msg (con_handle, &msg, &msg_size, NULL);
+    }
+  else
+    {
+      err_code = CCI_ER_COMMUNICATION;
+    }
+
+  if (req_handle == NULL
+      || req_handle->read_ahead_state != READ_AHEAD_SENT)
+    {
+      FREE_MSG_BUF (msg);
+      return err_code;
+    }
+
+  if (err_code < 0)
+    {
+      /* the fetch is retried synchronously and reports the error */
+      FREE_MSG_BUF (msg);
+      req_handle->read_ahead_state = READ_AHEAD_NONE;
+      return err_code;
+    }
+
+  req_handle->read_ahead_msg = msg;
+  req_handle->read_ahead_msg_size = msg_size;
+  req_handle->read_ahead_state = READ_AHEAD_RECEIVED;
+
+  return 0;
+}
+
+/*
+ * Return a reply buffer to the arena of the connection that received it.
+ * Buffers beyond RECV_ARENA_MAX_FREE are released to the heap.
+ */
+void
+net_msg_buf_free (char *msg)
+{
+  T_RECV_ARENA *arena;
+  char *buf;
+
+  if (msg == NULL)
+    {
+      return;
+    }
+
+  buf = msg - RECV_BUF_HEADER_SIZE;
+  arena = RECV_BUF_HEADER (msg)->arena;
+
+  if (arena->num_free < RECV_ARENA_MAX_FREE)
+    {
+      arena->free_buf[arena->num_free++] = buf;
+    }
+  else
+    {
+      FREE (buf);
+    }
+}
+
+void
+net_recv_arena_clear (T_RECV_ARENA * arena)
+{
+  int i;
+
+  for (i = 0; i < arena->num_free; i++)
+    {
+      FREE_MEM (arena->free_buf[i]);
+    }
+  arena->num_free = 0;
+  arena->peak_size = 0;
+  arena->num_recv = 0;
+}
+
+static char *
+net_recv_arena_alloc (T_RECV_ARENA * arena, int size)
+{
+  T_RECV_BUF_HEADER *header;
+  char *buf = NULL;
+  char *new_buf;
+  int capacity;
+  int best = -1;
+  int best_capacity = 0;
+  int i;
+
+  if (size > arena->peak_size)
+    {
+      arena->peak_size = size;
+    }
+  if (++arena->num_recv >= RECV_ARENA_WINDOW)
+    {
+      net_recv_arena_shrink (arena);
+    }
+
+  /* the smallest cached buffer that holds the reply */
+  for (i = 0; i < arena->num_free; i++)
+    {
+      header = (T_RECV_BUF_HEADER *) arena->free_buf[i];
+      if (header->capacity >= size
+	  && (best < 0 || header->capacity < best_capacity))
+	{
+	  best = i;
+	  best_capacity = header->capacity;
+	}
+    }
+
+  if (best >= 0)
+    {
+      buf = arena->free_buf[best];
+      arena->free_buf[best] = arena->free_buf[--arena->num_free];
+      return buf + RECV_BUF_HEADER_SIZE;
+    }
+
+  capacity = (size + RECV_BUF_ROUND_SIZE - 1) / RECV_BUF_ROUND_SIZE
+    * RECV_BUF_ROUND_SIZE;
+
+  /* every cached buffer is too small; grow one rather than keep both */
+  if (arena->num_free > 0)
+    {
+      buf = arena->free_buf[--arena->num_free];
+    }
+  new_buf = (char *) REALLOC (buf, RECV_BUF_HEADER_SIZE + capacity);
+  if (new_buf == NULL)
+    {
+      FREE_MEM (buf);
+      return NULL;
+    }
+
+  header = (T_RECV_BUF_HEADER *) new_buf;
+  header->arena = arena;
+  header->capacity = capacity;
+
+  return new_buf + RECV_BUF_HEADER_SIZE;
+}
+
+/*
+ * Drop cached buffers much larger than any reply of the last window, so
+ * that one huge fetch does not pin its memory for the life of the
+ * connection.
+ */
+static void
+net_recv_arena_shrink (T_RECV_ARENA * arena)
+{
+  T_RECV_BUF_HEADER *header;
+  int limit;
+  int i;
+
+  limit = arena->peak_size * 2;
+  if (limit < RECV_BUF_ROUND_SIZE)
+    {
+      limit = RECV_BUF_ROUND_SIZE;
+    }
+
+  for (i = 0; i < arena->num_free;)
+    {
+      header = (T_RECV_BUF_HEADER *) arena->free_buf[i];
+      if (header->capacity > limit)
+	{
+	  FREE (arena->free_buf[i]);
+	  arena->free_buf[i] = arena->free_buf[--arena->num_free];
+	}
+      else
+	{
+	  i++;
+	}
+    }
+
+  arena->peak_size = 0;
+  arena->num_recv = 0;
+}
+
 bool
 net_peer_alive (unsigned char *ip_addr, int port, int timeout_msec)
 {
@@ -890,23 +1143,16 @@ recv_again:
   return true;
 }
 
-bool
-net_check_broker_alive (unsigned char *ip_addr, int port, int timeout_msec)
+static void
+make_health_check_msg (unsigned char *ip_addr, int port, char *client_info,
+		       char *db_info)
 {
-  SOCKET sock_fd;
-  MSG_HEADER msg_header;
-  char client_info[SRV_CON_CLIENT_INFO_SIZE];
-  char db_info[SRV_CON_DB_INFO_SIZE];
   char db_name[SRV_CON_DBNAME_SIZE];
   char url[SRV_CON_URL_SIZE];
   char *info;
-  int err_code, ret_value;
-  bool result = false;
 
-  init_msg_header (&msg_header);
-
-  memset (client_info, 0, sizeof (client_info));
-  memset (db_info, 0, sizeof (db_info));
+  memset (client_info, 0, SRV_CON_CLIENT_INFO_SIZE);
+  memset (db_info, 0, SRV_CON_DB_INFO_SIZE);
 
   strncpy (client_info, SRV_CON_CLIENT_MAGIC_STR, SRV_CON_CLIENT_MAGIC_LEN);
   client_info[SRV_CON_MSG_IDX_CLIENT_TYPE] = cci_client_type;
@@ -924,6 +1170,20 @@ net_check_broker_alive (unsigned char *ip_addr, int port, int timeout_msec)
   info += (SRV_CON_DBNAME_SIZE + SRV_CON_DBUSER_SIZE + SRV_CON_DBPASSWD_SIZE);
 
   strncpy (info, url, SRV_CON_URL_SIZE - 1);
+}
+
+bool
+net_check_broker_alive (unsigned char *ip_addr, int port, int timeout_msec)
+{
+  SOCKET sock_fd;
+  MSG_HEADER msg_header;
+  char client_info[SRV_CON_CLIENT_INFO_SIZE];
+  char db_info[SRV_CON_DB_INFO_SIZE];
+  int err_code, ret_value;
+  bool result = false;
+
+  init_msg_header (&msg_header);
+  make_health_check_msg (ip_addr, port, client_info, db_info);
 
   if (connect_srv (ip_addr, port, 0, &sock_fd, timeout_msec) < 0)
     {
@@ -964,6 +1224,295 @@ finish_health_check:
   return result;
 }
 
+/*
+ * net_probe_brokers - run the health check handshake against many brokers
+ *   at once. The connects are non-blocking and all sockets are multiplexed
+ *   in one poll, so a broker that does not answer delays the others by no
+ *   more than timeout_msec. rtt_msec of each probe is set to the time the
+ *   handshake took, or -1 if the broker did not answer in time.
+ */
+void
+net_probe_brokers (T_BROKER_PROBE * probes, int count, int timeout_msec)
+{
+  int i;
+
+  for (i = 0; i < count; i += PROBE_BATCH_SIZE)
+    {
+      probe_broker_batch (probes + i, MIN (count - i, PROBE_BATCH_SIZE),
+			  timeout_msec);
+    }
+}
+
+static void
+probe_broker_batch (T_BROKER_PROBE * probes, int count, int timeout_msec)
+{
+  T_PROBE_CONN conn[PROBE_BATCH_SIZE];
+  struct timeval start_time;
+  int i, n, pending = 0;
+  int remaining;
+
+  gettimeofday (&start_time, NULL);
+
+  for (i = 0; i < count; i++)
+    {
+      probes[i].rtt_msec = -1;
+      conn[i].state = PROBE_DONE;
+      conn[i].ready = 0;
+      conn[i].received = 0;
+
+      if (probe_connect (&probes[i].host, &conn[i].sock_fd) == 0)
+	{
+	  conn[i].state = PROBE_CONNECTING;
+	  pending++;
+	}
+    }
+
+  while (pending > 0)
+    {
+      remaining = timeout_msec - get_elapsed_time (&start_time);
+      if (remaining <= 0)
+	{
+	  break;
+	}
+
+      n = probe_wait (conn, count, remaining);
+      if (n < 0)
+	{
+	  break;
+	}
+
+      for (i = 0; i < count && n > 0; i++)
+	{
+	  if (!conn[i].ready)
+	    {
+	      continue;
+	    }
+	  n--;
+
+	  if (probe_step (&probes[i], &conn[i], &start_time) < 0)
+	    {
+	      conn[i].state = PROBE_DONE;
+	      probes[i].rtt_msec = -1;
+	    }
+	  if (conn[i].state == PROBE_DONE)
+	    {
+	      CLOSE_SOCKET (conn[i].sock_fd);
+	      pending--;
+	    }
+	}
+    }
+
+  for (i = 0; i < count; i++)
+    {
+      if (conn[i].state != PROBE_DONE)
+	{
+	  CLOSE_SOCKET (conn[i].sock_fd);
+	}
+    }
+}
+
+static int
+probe_connect (T_ALTER_HOST * host, SOCKET * ret_sock)
+{
+  struct sockaddr_in sock_addr;
+  SOCKET sock_fd;
+  int ret;
+#if defined (WINDOWS)
+  u_long ioctl_opt = 1;
+#endif
+
+  sock_fd = socket (AF_INET, SOCK_STREAM, 0);
+  if (IS_INVALID_SOCKET (sock_fd))
+    {
+      return CCI_ER_CONNECT;
+    }
+
+  memset (&sock_addr, 0, sizeof (struct sockaddr_in));
+  sock_addr.sin_family = AF_INET;
+  sock_addr.sin_port = htons ((unsigned short) host->port);
+  memcpy (&sock_addr.sin_addr, host->ip_addr, 4);
+
+#if defined (WINDOWS)
+  if (ioctlsocket (sock_fd, FIONBIO, &ioctl_opt) < 0)
+    {
+      CLOSE_SOCKET (sock_fd);
+      return CCI_ER_CONNECT;
+    }
+#else
+  fcntl (sock_fd, F_SETFL, fcntl (sock_fd, F_GETFL) | O_NONBLOCK);
+#endif
+
+  ret = connect (sock_fd, (struct sockaddr *) &sock_addr,
+		 sizeof (struct sockaddr_in));
+#if defined (WINDOWS)
+  if (ret < 0 && WSAGetLastError () != WSAEWOULDBLOCK)
+#else
+  if (ret < 0 && errno != EINPROGRESS)
+#endif
+    {
+      CLOSE_SOCKET (sock_fd);
+      return CCI_ER_CONNECT;
+    }
+
+  *ret_sock = sock_fd;
+  return CCI_ER_NO_ERROR;
+}
+
+/*
+ * probe_wait - wait until one of the pending probes can go on; a probe
+ *   in PROBE_CONNECTING waits for its socket to become writable, the
+ *   others for a reply. Returns the number of probes marked ready.
+ */
+static int
+probe_wait (T_PROBE_CONN * conn, int count, int timeout_msec)
+{
+  int i, n, ready = 0;
+#if defined (WINDOWS)
+  fd_set rset, wset, eset;
+  struct timeval tv;
+
+  FD_ZERO (&rset);
+  FD_ZERO (&wset);
+  FD_ZERO (&eset);
+  for (i = 0; i < count; i++)
+    {
+      conn[i].ready = 0;
+      if (conn[i].state == PROBE_CONNECTING)
+	{
+	  FD_SET (conn[i].sock_fd, &wset);
+	  FD_SET (conn[i].sock_fd, &eset);
+	}
+      else if (conn[i].state != PROBE_DONE)
+	{
+	  FD_SET (conn[i].sock_fd, &rset);
+	}
+    }
+
+  tv.tv_sec = timeout_msec / 1000;
+  tv.tv_usec = (timeout_msec % 1000) * 1000;
+
+  n = select (0, &rset, &wset, &eset, &tv);
+  if (n <= 0)
+    {
+      return n;
+    }
+
+  for (i = 0; i < count; i++)
+    {
+      if (conn[i].state != PROBE_DONE
+	  && (FD_ISSET (conn[i].sock_fd, &rset)
+	      || FD_ISSET (conn[i].sock_fd, &wset)
+	      || FD_ISSET (conn[i].sock_fd, &eset)))
+	{
+	  conn[i].ready = 1;
+	  ready++;
+	}
+    }
+#else
+  struct pollfd po[PROBE_BATCH_SIZE];
+
+  for (i = 0; i < count; i++)
+    {
+      conn[i].ready = 0;
+      po[i].fd = (conn[i].state == PROBE_DONE) ? -1 : conn[i].sock_fd;
+      po[i].events = (conn[i].state == PROBE_CONNECTING) ? POLLOUT : POLLIN;
+      po[i].revents = 0;
+    }
+
+  n = poll (po, count, timeout_msec);
+  if (n <= 0)
+    {
+      return (n < 0 && errno == EINTR) ? 0 : n;
+    }
+
+  for (i = 0; i < count; i++)
+    {
+      if (po[i].revents != 0)
+	{
+	  conn[i].ready = 1;
+	  ready++;
+	}
+    }
+#endif
+
+  return ready;
+}
+
+static int
+probe_step (T_BROKER_PROBE * probe, T_PROBE_CONN * conn,
+	    struct timeval *start_time)
+{
+  char client_info[SRV_CON_CLIENT_INFO_SIZE];
+  char db_info[SRV_CON_DB_INFO_SIZE];
+  int n, size, err_code, sock_err = 0;
+  socklen_t len = sizeof (sock_err);
+
+  switch (conn->state)
+    {
+    case PROBE_CONNECTING:
+      if (getsockopt (conn->sock_fd, SOL_SOCKET, SO_ERROR,
+		      (char *) &sock_err, &len) < 0 || sock_err != 0)
+	{
+	  return CCI_ER_CONNECT;
+	}
+
+      /* the handshake messages are far smaller than the send buffer of a
+       * new socket, so a short write means the peer went away */
+      make_health_check_msg (probe->host.ip_addr, probe->host.port,
+			     client_info, db_info);
+      if (WRITE_TO_SOCKET (conn->sock_fd, client_info,
+			   SRV_CON_CLIENT_INFO_SIZE) !=
+	  SRV_CON_CLIENT_INFO_SIZE)
+	{
+	  return CCI_ER_COMMUNICATION;
+	}
+      conn->state = PROBE_RECV_PORT;
+      return 0;
+
+    case PROBE_RECV_PORT:
+    case PROBE_RECV_HEADER:
+      size = (conn->state == PROBE_RECV_PORT) ? 4 : MSG_HEADER_SIZE;
+      n = READ_FROM_SOCKET (conn->sock_fd, conn->buf + conn->received,
+			    size - conn->received);
+      if (n <= 0)
+	{
+	  return CCI_ER_COMMUNICATION;
+	}
+      conn->received += n;
+      if (conn->received < size)
+	{
+	  return 0;
+	}
+      conn->received = 0;
+
+      if (conn->state == PROBE_RECV_HEADER)
+	{
+	  probe->rtt_msec = get_elapsed_time (start_time);
+	  conn->state = PROBE_DONE;
+	  return 0;
+	}
+
+      memcpy (&err_code, conn->buf, 4);
+      if ((int) ntohl (err_code) < 0)
+	{
+	  return CCI_ER_COMMUNICATION;
+	}
+
+      make_health_check_msg (probe->host.ip_addr, probe->host.port,
+			     client_info, db_info);
+      if (WRITE_TO_SOCKET (conn->sock_fd, db_info, SRV_CON_DB_INFO_SIZE) !=
+	  SRV_CON_DB_INFO_SIZE)
+	{
+	  return CCI_ER_COMMUNICATION;
+	}
+      conn->state = PROBE_RECV_HEADER;
+      return 0;
+
+    default:
+      return 0;
+    }
+}
+
 #if defined (ENABLE_UNUSED_FUNCTION)
 int
 net_send_file (SOCKET sock_fd, char *filename, int filesize)
@@ -1058,6 +1607,39 @@ static int
 net_recv_stream (SOCKET sock_fd, int port, char *buf, int size, int timeout)
 {
   int read_len, tot_read_len = 0;
+  int err;
+
+  while (tot_read_len < size)
+    {
+      err = net_wait_readable (sock_fd, port, &timeout);
+      if (err < 0)
+	{
+	  assert (err != CCI_ER_QUERY_TIMEOUT
+		  || tot_read_len == 0 || size == tot_read_len);
+	  return err;
+	}
+
+      read_len = READ_FROM_SOCKET (sock_fd, buf + tot_read_len,
+				   size - tot_read_len);
+      if (read_len <= 0)
+	{
+	  return CCI_ER_COMMUNICATION;
+	}
+
+      tot_read_len += read_len;
+    }
+
+  return 0;
+}
+
+/*
+ * Wait until sock_fd has data to read. A positive *timeout (msec) is
+ * consumed in SOCKET_TIMEOUT steps; otherwise the wait lasts as long as
+ * the peer is alive.
+ */
+static int
+net_wait_readable (SOCKET sock_fd, int port, int *timeout)
+{
 #if defined(WINDOWS)
   fd_set rfds;
   struct timeval tv;
@@ -1067,21 +1649,21 @@ net_recv_stream (SOCKET sock_fd, int port, char *buf, int size, int timeout)
 #endif
   int n;
 
-  while (tot_read_len < size)
+  while (1)
     {
 #if defined(WINDOWS)
       FD_ZERO (&rfds);
       FD_SET (sock_fd, &rfds);
 
-      if (timeout <= 0 || timeout > SOCKET_TIMEOUT)
+      if (*timeout <= 0 || *timeout > SOCKET_TIMEOUT)
 	{
 	  tv.tv_sec = SOCKET_TIMEOUT / 1000;
 	  tv.tv_usec = (SOCKET_TIMEOUT % 1000) * 1000;
 	}
       else
 	{
-	  tv.tv_sec = timeout / 1000;
-	  tv.tv_usec = (timeout % 1000) * 1000;
+	  tv.tv_sec = *timeout / 1000;
+	  tv.tv_usec = (*timeout % 1000) * 1000;
 	}
 
       n = select (sock_fd + 1, &rfds, NULL, NULL, &tv);
@@ -1090,13 +1672,13 @@ net_recv_stream (SOCKET sock_fd, int port, char *buf, int size, int timeout)
       po[0].fd = sock_fd;
       po[0].events = POLLIN;
 
-      if (timeout <= 0 || timeout > SOCKET_TIMEOUT)
+      if (*timeout <= 0 || *timeout > SOCKET_TIMEOUT)
 	{
 	  polling_timeout = SOCKET_TIMEOUT;
 	}
       else
 	{
-	  polling_timeout = timeout;
+	  polling_timeout = *timeout;
 	}
 
       n = poll (po, 1, polling_timeout);
@@ -1106,12 +1688,11 @@ net_recv_stream (SOCKET sock_fd, int port, char *buf, int size, int timeout)
       if (n == 0)
 	{
 	  /* select / poll return time out */
-	  if (timeout > 0)
+	  if (*timeout > 0)
 	    {
-	      timeout -= SOCKET_TIMEOUT;
-	      if (timeout <= 0)
+	      *timeout -= SOCKET_TIMEOUT;
+	      if (*timeout <= 0)
 		{
-		  assert (tot_read_len == 0 || size == tot_read_len);
 		  return CCI_ER_QUERY_TIMEOUT;
 		}
 	      else
@@ -1147,14 +1728,124 @@ net_recv_stream (SOCKET sock_fd, int port, char *buf, int size, int timeout)
 	}
 #endif /* !WINDOWS */
 
-      read_len = READ_FROM_SOCKET (sock_fd, buf + tot_read_len,
-				   size - tot_read_len);
-      if (read_len <= 0)
+      return 0;
+    }
+}
+
+/*
+ * Read whatever is available on sock_fd, up to size bytes. The socket is
+ * tried without blocking first and polled only when it has nothing yet.
+ * Returns the number of bytes read or an error code.
+ */
+static int
+net_recv_some (SOCKET sock_fd, int port, char *buf, int size, int *timeout)
+{
+  int read_len;
+  int err;
+
+#if defined(WINDOWS) || !defined(MSG_DONTWAIT)
+  err = net_wait_readable (sock_fd, port, timeout);
+  if (err < 0)
+    {
+      return err;
+    }
+
+  read_len = READ_FROM_SOCKET (sock_fd, buf, size);
+  if (read_len <= 0)
+    {
+      return CCI_ER_COMMUNICATION;
+    }
+#else
+  while (1)
+    {
+      read_len = recv (sock_fd, buf, size, MSG_DONTWAIT);
+      if (read_len > 0)
+	{
+	  break;
+	}
+      if (read_len == 0)
+	{
+	  return CCI_ER_COMMUNICATION;
+	}
+      if (errno == EINTR)
+	{
+	  continue;
+	}
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
 	{
 	  return CCI_ER_COMMUNICATION;
 	}
 
-      tot_read_len += read_len;
+      err = net_wait_readable (sock_fd, port, timeout);
+      if (err < 0)
+	{
+	  return err;
+	}
+    }
+#endif /* WINDOWS || !MSG_DONTWAIT */
+
+  return read_len;
+}
+
+/*
+ * Receive size bytes of the connection's reply stream. Reads go through
+ * con_handle->sock_read_buf so that a small reply's header and body are
+ * usually taken from a single recv; requests at least as large as the
+ * buffer are read straight into buf.
+ */
+static int
+net_recv_con_stream (T_CON_HANDLE * con_handle, int port, char *buf,
+		     int size, int timeout)
+{
+  T_SOCK_READ_BUF *read_buf = &con_handle->sock_read_buf;
+  int read_len, copy_len, tot_read_len = 0;
+
+  if (read_buf->buf == NULL)
+    {
+      read_buf->buf = (char *) MALLOC (SOCK_READ_BUF_SIZE);
+      if (read_buf->buf == NULL)
+	{
+	  return CCI_ER_NO_MORE_MEMORY;
+	}
+      read_buf->begin = read_buf->end = 0;
+    }
+
+  while (tot_read_len < size)
+    {
+      if (read_buf->begin < read_buf->end)
+	{
+	  copy_len = MIN (read_buf->end - read_buf->begin,
+			  size - tot_read_len);
+	  memcpy (buf + tot_read_len, read_buf->buf + read_buf->begin,
+		  copy_len);
+	  read_buf->begin += copy_len;
+	  tot_read_len += copy_len;
+	  continue;
+	}
+
+      read_buf->begin = read_buf->end = 0;
+
+      if (size - tot_read_len >= SOCK_READ_BUF_SIZE)
+	{
+	  read_len = net_recv_some (con_handle->sock_fd, port,
+				    buf + tot_read_len, size - tot_read_len,
+				    &timeout);
+	  if (read_len < 0)
+	    {
+	      return read_len;
+	    }
+	  tot_read_len += read_len;
+	}
+      else
+	{
+	  read_len = net_recv_some (con_handle->sock_fd, port, read_buf->buf,
+				    SOCK_READ_BUF_SIZE, &timeout);
+	  if (read_len < 0)
+	    {
+	      return read_len;
+	    }
+	  read_buf->end = read_len;
+	}
     }
 
   return 0;
@@ -1207,14 +1898,24 @@ net_recv_msg_header (SOCKET sock_fd, int port, MSG_HEADER * header,
 }
 
 static int
-net_send_msg_header (SOCKET sock_fd, MSG_HEADER * header)
+net_recv_con_msg_header (T_CON_HANDLE * con_handle, int port,
+			 MSG_HEADER * header, int timeout)
 {
-  *(header->msg_body_size_ptr) = htonl (*(header->msg_body_size_ptr));
-  if (net_send_stream (sock_fd, header->buf, MSG_HEADER_SIZE) < 0)
+  int result_code;
+
+  result_code = net_recv_con_stream (con_handle, port, header->buf,
+				     MSG_HEADER_SIZE, timeout);
+
+  if (result_code < 0)
     {
-      return CCI_ER_COMMUNICATION;
+      return result_code;
     }
+  *(header->msg_body_size_ptr) = ntohl (*(header->msg_body_size_ptr));
 
+  if ((*header->msg_body_size_ptr) < 0)
+    {
+      return CCI_ER_COMMUNICATION;
+    }
   return 0;
 }
 
@@ -1235,6 +1936,81 @@ net_send_stream (SOCKET sock_fd, char *msg, int size)
   return 0;
 }
 
+/*
+ * Send two buffers back to back with scatter-gather writes, so that a
+ * message header and its body leave in one segment.
+ */
+static int
+net_send_stream_vec (SOCKET sock_fd, char *buf1, int size1, char *buf2,
+		     int size2)
+{
+#if defined(WINDOWS)
+  WSABUF iov[2];
+  DWORD write_len;
+#else
+  struct iovec iov[2];
+  ssize_t write_len;
+#endif
+  int iov_index = 0;
+  int iov_count;
+
+#if defined(WINDOWS)
+  iov[0].buf = buf1;
+  iov[0].len = size1;
+  iov[1].buf = buf2;
+  iov[1].len = size2;
+#else
+  iov[0].iov_base = buf1;
+  iov[0].iov_len = size1;
+  iov[1].iov_base = buf2;
+  iov[1].iov_len = size2;
+#endif
+  iov_count = (buf2 != NULL && size2 > 0) ? 2 : 1;
+
+  while (iov_index < iov_count)
+    {
+#if defined(WINDOWS)
+      if (WSASend (sock_fd, iov + iov_index, iov_count - iov_index,
+		   &write_len, 0, NULL, NULL) != 0 || write_len == 0)
+	{
+	  return CCI_ER_COMMUNICATION;
+	}
+
+      while (iov_index < iov_count && write_len >= iov[iov_index].len)
+	{
+	  write_len -= iov[iov_index].len;
+	  iov_index++;
+	}
+      if (iov_index < iov_count)
+	{
+	  iov[iov_index].buf += write_len;
+	  iov[iov_index].len -= write_len;
+	}
+#else
+      write_len = writev (sock_fd, iov + iov_index, iov_count - iov_index);
+      if (write_len <= 0)
+	{
+	  return CCI_ER_COMMUNICATION;
+	}
+
+      while (iov_index < iov_count
+	     && (size_t) write_len >= iov[iov_index].iov_len)
+	{
+	  write_len -= iov[iov_index].iov_len;
+	  iov_index++;
+	}
+      if (iov_index < iov_count)
+	{
+	  iov[iov_index].iov_base = (char *) iov[iov_index].iov_base
+	    + write_len;
+	  iov[iov_index].iov_len -= write_len;
+	}
+#endif
+    }
+
+  return 0;
+}
+
 static void
 init_msg_header (MSG_HEADER * header)
 {
@@ -68,6 +68,14 @@
 
 #define BROKER_HEALTH_CHECK_TIMEOUT	5000
 
+#define FREE_MSG_BUF(PTR)		\
+	do {				\
+	  if (PTR) {			\
+	    net_msg_buf_free (PTR);	\
+	    (PTR) = 0;			\
+	  }				\
+	} while (0)
+
 /************************************************************************
  * EXPORTED TYPE DEFINITIONS						*
  ************************************************************************/
@@ -77,6 +85,12 @@ typedef struct
   char *info_ptr;
   char buf[MSG_HEADER_SIZE];
 } MSG_HEADER;
+
+typedef struct
+{
+  T_ALTER_HOST host;
+  int rtt_msec;			/* -1 if the broker did not answer */
+} T_BROKER_PROBE;
 /************************************************************************
  * EXPORTED FUNCTION PROTOTYPES						*
  ************************************************************************/
@@ -89,6 +103,9 @@ extern int net_recv_msg (T_CON_HANDLE * con_handle, char **msg, int *size,
 extern int net_recv_msg_timeout (T_CON_HANDLE * con_handle, char **msg,
 				 int *msg_size, T_CCI_ERROR * err_buf,
 				 int timeout);
+extern int net_recv_read_ahead (T_CON_HANDLE * con_handle);
+extern void net_msg_buf_free (char *msg);
+extern void net_recv_arena_clear (T_RECV_ARENA * arena);
 #if defined (ENABLE_UNUSED_FUNCTION)
 extern int net_send_file (SOCKET sock_fd, char *filename, int filesize);
 extern int net_recv_file (SOCKET sock_fd, int port, int file_size,
@@ -100,6 +117,8 @@ extern bool net_peer_alive (unsigned char *ip_addr, int port,
 			    int timeout_msec);
 extern bool net_check_broker_alive (unsigned char *ip_addr, int port,
 				    int timeout_msec);
+extern void net_probe_brokers (T_BROKER_PROBE * probes, int count,
+			       int timeout_msec);
 /************************************************************************
  * EXPORTED VARIABLES							*
  ************************************************************************/
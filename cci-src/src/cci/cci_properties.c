@@ -349,6 +349,7 @@ cci_conn_set_properties (T_CON_HANDLE * handle, char *properties)
     {"queryTimeout", INT_PROPERTY, &handle->query_timeout},
     {"disconnectOnQueryTimeout", BOOL_PROPERTY,
      &handle->disconnect_on_query_timeout},
+    {"deferCloseHandles", BOOL_PROPERTY, &handle->defer_close_handles},
     {"logFile", STRING_PROPERTY, &file},
     {"logOnException", BOOL_PROPERTY, &handle->log_on_exception},
     {"logSlowQueries", BOOL_PROPERTY, &handle->log_slow_queries},
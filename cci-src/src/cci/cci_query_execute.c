@@ -72,66 +72,26 @@
 /************************************************************************
  * PRIVATE DEFINITIONS							*
  ************************************************************************/
-#define ALLOC_COPY_BIGINT(PTR, VALUE)      \
-        do {                            \
-          PTR = MALLOC(sizeof(INT64));  \
-          if (PTR != NULL) {            \
-            *((INT64*) (PTR)) = VALUE;  \
-          }                             \
-        } while (0)
-
-#define ALLOC_COPY_INT(PTR, VALUE)	\
-	do {				\
-	  PTR = MALLOC(sizeof(int));	\
-	  if (PTR != NULL) {		\
-	    *((int*) (PTR)) = VALUE;	\
-	  }				\
-	} while (0)
-
-#define ALLOC_COPY_FLOAT(PTR, VALUE)	\
-	do {				\
-	  PTR = MALLOC(sizeof(float));	\
-	  if (PTR != NULL) {		\
-	    *((float*) (PTR)) = VALUE;	\
-	  }				\
-	} while (0)
-
-#define ALLOC_COPY_DOUBLE(PTR, VALUE)	\
-	do {				\
-	  PTR = MALLOC(sizeof(double));	\
-	  if (PTR != NULL) {		\
-	    *((double*) (PTR)) = VALUE;	\
-	  }				\
-	} while (0)
-
-#define ALLOC_COPY_DATE(PTR, VALUE)		\
-	do {					\
-	  PTR = MALLOC(sizeof(T_CCI_DATE));	\
-	  if (PTR != NULL) {			\
-	    *((T_CCI_DATE*) (PTR)) = VALUE;	\
-	  }					\
-	} while (0)
-
-#define ALLOC_COPY_OBJECT(PTR, VALUE)		\
-	do {					\
-	  PTR = MALLOC(sizeof(T_OBJECT));	\
-	  if (PTR != NULL) {			\
-	    *((T_OBJECT*) (PTR)) = VALUE;	\
-	  }					\
-	} while (0)
-
-#define ALLOC_COPY_BIT(DEST, SRC, SIZE)		\
-	do {					\
-	  DEST = MALLOC(SIZE);			\
-	  if (DEST != NULL) {			\
-	    memcpy(DEST, SRC, SIZE);		\
-	  }					\
+/* store a fixed size value in the inline storage of a T_BIND_VALUE */
+#define BIND_VALUE_SET_INLINE(BIND_VALUE, MEMBER, VALUE)		\
+	do {								\
+	  (BIND_VALUE)->inline_value.MEMBER = (VALUE);			\
+	  (BIND_VALUE)->value = &((BIND_VALUE)->inline_value.MEMBER);	\
+	  (BIND_VALUE)->flag = BIND_PTR_INLINE;				\
 	} while (0)
 
 #define EXECUTE_ARRAY	0
 #define EXECUTE_BATCH	1
 #define EXECUTE_EXEC	2
 
+#define ADAPTIVE_FETCH_SIZE_MAX		100000
+
+/* wire size of a bind value besides its data: type (length + 1 byte)
+ * and the data length */
+#define BIND_VALUE_NET_OVERHEAD		(NET_SIZE_INT * 2 + NET_SIZE_BYTE)
+/* assumed width of one bind array value */
+#define BIND_ARRAY_WIDTH_HINT		16
+
 /************************************************************************
  * PRIVATE TYPE DEFINITIONS						*
  ************************************************************************/
@@ -180,11 +140,16 @@ static int col_get_info_decode (char *buf_p, int remain_size, int *col_size,
 static int next_result_info_decode (char *buf, int size,
 				    T_REQ_HANDLE * req_handle);
 static int bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type,
-				  char flag, void *value,
+				  char flag, void *value, int length,
 				  T_BIND_VALUE * bind_value);
 static int bind_value_to_net_buf (T_NET_BUF * net_buf, char u_type,
 				  void *value, int size, char *charset,
 				  bool set_default_value);
+static int bind_value_copy (T_BIND_VALUE * bind_value, const void *value,
+			    int size);
+static int bind_value_copy_str (T_BIND_VALUE * bind_value, const char *str,
+				int length);
+static int bind_value_size_hint (T_REQ_HANDLE * req_handle, bool is_array);
 static int execute_array_info_decode (char *buf, int size, char flag,
 				      T_CCI_QUERY_RESULT ** qr,
 				      int *res_remain_size);
@@ -195,6 +160,10 @@ static int decode_fetch_result (T_CON_HANDLE * con_handle,
 				T_REQ_HANDLE * req_handle,
 				char *result_msg_org, char *result_msg_start,
 				int result_msg_size);
+static void adjust_fetch_size (T_REQ_HANDLE * req_handle, int msg_size,
+			       int num_tuple);
+static void read_ahead_fetch (T_REQ_HANDLE * req_handle,
+			      T_CON_HANDLE * con_handle);
 static int qe_close_req_handle_internal (T_REQ_HANDLE * req_handle,
 					 T_CON_HANDLE * con_handle,
 					 bool force_close);
@@ -283,7 +252,7 @@ qe_end_tran (T_CON_HANDLE * con_handle, char type, T_CCI_ERROR * err_buf)
       return 0;
     }
 
-  net_buf_init (&net_buf);
+  net_buf_init_spare (&net_buf, &con_handle->send_buf);
 
   net_buf_cp_str (&net_buf, &func_code, 1);
 
@@ -297,12 +266,12 @@ qe_end_tran (T_CON_HANDLE * con_handle, char type, T_CCI_ERROR * err_buf)
   if (net_buf.err_code < 0)
     {
       err_code = net_buf.err_code;
-      net_buf_clear (&net_buf);
+      net_buf_clear_spare (&net_buf, &con_handle->send_buf);
       return err_code;
     }
 
   err_code = net_send_msg (con_handle, net_buf.data, net_buf.data_size);
-  net_buf_clear (&net_buf);
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
   if (err_code < 0)
     return err_code;
 
@@ -424,7 +393,7 @@ qe_prepare (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 
   sql_stmt_size = strlen (req_handle->sql_text) + 1;
 
-  net_buf_init (&net_buf);
+  net_buf_init_spare (&net_buf, &con_handle->send_buf);
 
   net_buf_cp_str (&net_buf, &func_code, 1);
 
@@ -451,7 +420,7 @@ qe_prepare (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
   if (net_buf.err_code < 0)
     {
       err_code = net_buf.err_code;
-      net_buf_clear (&net_buf);
+      net_buf_clear_spare (&net_buf, &con_handle->send_buf);
       return err_code;
     }
 
@@ -461,13 +430,13 @@ qe_prepare (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
       remaining_time -= get_elapsed_time (&con_handle->start_time);
       if (remaining_time <= 0)
 	{
-	  net_buf_clear (&net_buf);
+	  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
 	  return CCI_ER_QUERY_TIMEOUT;
 	}
     }
 
   err_code = net_send_msg (con_handle, net_buf.data, net_buf.data_size);
-  net_buf_clear (&net_buf);
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
   if (err_code < 0)
     {
       return err_code;
@@ -486,11 +455,11 @@ qe_prepare (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
     prepare_info_decode (result_msg + 4, &result_msg_size, req_handle);
   if (err_code < 0)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return err_code;
     }
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   req_handle->handle_type = HANDLE_PREPARE;
   req_handle->server_handle_id = result_code;
@@ -536,7 +505,7 @@ qe_prepare (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 
 int
 qe_bind_param (T_REQ_HANDLE * req_handle, int index, T_CCI_A_TYPE a_type,
-	       void *value, T_CCI_U_TYPE u_type, char flag)
+	       void *value, int length, T_CCI_U_TYPE u_type, char flag)
 {
   int err_code;
 
@@ -550,8 +519,9 @@ qe_bind_param (T_REQ_HANDLE * req_handle, int index, T_CCI_A_TYPE a_type,
   if (req_handle->bind_value[index].flag == BIND_PTR_DYNAMIC)
     {
       FREE_MEM (req_handle->bind_value[index].value);
-      memset (&(req_handle->bind_value[index]), 0, sizeof (T_BIND_VALUE));
     }
+  req_handle->bind_value[index].value = NULL;
+  req_handle->bind_value[index].flag = BIND_PTR_STATIC;
 
   req_handle->bind_mode[index] = CCI_PARAM_MODE_IN;
 
@@ -562,7 +532,7 @@ qe_bind_param (T_REQ_HANDLE * req_handle, int index, T_CCI_A_TYPE a_type,
     }
 
   err_code =
-    bind_value_conversion (a_type, u_type, flag, value,
+    bind_value_conversion (a_type, u_type, flag, value, length,
 			   &(req_handle->bind_value[index]));
 
   return err_code;
@@ -593,7 +563,7 @@ qe_execute (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, char flag,
   req_handle->is_fetch_completed = 0;
   QUERY_RESULT_FREE (req_handle);
 
-  net_buf_init (&net_buf);
+  net_buf_init_spare (&net_buf, &con_handle->send_buf);
 
   net_buf_cp_str (&net_buf, &func_code, 1);
 
@@ -664,6 +634,7 @@ qe_execute (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, char flag,
       ADD_ARG_INT (&net_buf, 0);
     }
 
+  net_buf_reserve (&net_buf, bind_value_size_hint (req_handle, false));
   for (i = 0; i < req_handle->num_bind; i++)
     {
       bind_value_to_net_buf (&net_buf,
@@ -690,7 +661,7 @@ qe_execute (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, char flag,
       goto execute_error;
     }
 
-  net_buf_clear (&net_buf);
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
 
   res_count = net_recv_msg_timeout (con_handle, &result_msg,
 				    &result_msg_size, err_buf,
@@ -757,7 +728,7 @@ qe_execute (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, char flag,
 	  err_code = prepare_info_decode (msg, &remain_msg_size, req_handle);
 	  if (err_code < 0)
 	    {
-	      FREE_MEM (result_msg);
+	      FREE_MSG_BUF (result_msg);
 	      return err_code;
 	    }
 	}
@@ -792,13 +763,13 @@ qe_execute (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, char flag,
       req_handle->cursor_pos = 0;
       if (num_tuple < 0)
 	{
-	  FREE_MEM (result_msg);
+	  FREE_MSG_BUF (result_msg);
 	  return num_tuple;
 	}
     }
   else
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
     }
 
   req_handle->is_closed = 0;
@@ -807,7 +778,7 @@ qe_execute (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, char flag,
   return res_count;
 
 execute_error:
-  net_buf_clear (&net_buf);
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
   return err_code;
 }
 
@@ -851,7 +822,7 @@ qe_prepare_and_execute (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 
   sql_stmt_size = strlen (req_handle->sql_text) + 1;
 
-  net_buf_init (&net_buf);
+  net_buf_init_spare (&net_buf, &con_handle->send_buf);
 
   /* prepare info */
   broker_ver = hm_get_broker_version (con_handle);
@@ -924,7 +895,7 @@ qe_prepare_and_execute (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
       goto prepare_and_execute_error;
     }
 
-  net_buf_clear (&net_buf);
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
 
 
   /* prepare result */
@@ -946,7 +917,7 @@ qe_prepare_and_execute (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 
   if (err_code < 0)
     {
-      FREE_MEM (result_msg_org);
+      FREE_MSG_BUF (result_msg_org);
       return err_code;
     }
 
@@ -1037,7 +1008,7 @@ qe_prepare_and_execute (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 	  err_code = prepare_info_decode (msg, &remain_msg_size, req_handle);
 	  if (err_code < 0)
 	    {
-	      FREE_MEM (result_msg);
+	      FREE_MSG_BUF (result_msg);
 	      return err_code;
 	    }
 	}
@@ -1069,19 +1040,19 @@ qe_prepare_and_execute (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
       req_handle->cursor_pos = 0;
       if (num_tuple < 0)
 	{
-	  FREE_MEM (result_msg_org);
+	  FREE_MSG_BUF (result_msg_org);
 	  return num_tuple;
 	}
     }
   else
     {
-      FREE_MEM (result_msg_org);
+      FREE_MSG_BUF (result_msg_org);
     }
 
   return execute_res_count;
 
 prepare_and_execute_error:
-  net_buf_clear (&net_buf);
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
   return err_code;
 }
 
@@ -1179,7 +1150,7 @@ qe_get_db_parameter (T_CON_HANDLE * con_handle, T_CCI_DB_PARAM param_name,
 	    }
 	}
 
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
     }
 
   return err_code;
@@ -1293,11 +1264,11 @@ qe_set_cas_change_mode (T_CON_HANDLE * con_handle, int mode,
 
   if (result_msg_size < NET_SIZE_INT)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return CCI_ER_COMMUNICATION;
     }
   NET_STR_TO_INT (prev_mode, cur_p);
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   return prev_mode;
 }
@@ -1377,7 +1348,17 @@ qe_close_req_handle_internal (T_REQ_HANDLE * req_handle,
       req_handle->stmt_type == CUBRID_STMT_CALL_SP ||
       req_handle->stmt_type == CUBRID_STMT_EVALUATE || force_close)
     {
-      goto send_close_handle_msg;
+      /* with deferCloseHandles, result sets are closed by the next
+       * prepare too, unless the close has to end an autocommit
+       * transaction or too many closes are pending already */
+      if (force_close || !con_handle->defer_close_handles
+	  || (con_handle->autocommit_mode == CCI_AUTOCOMMIT_TRUE
+	      && con_handle->con_status == CCI_CON_STATUS_IN_TRAN)
+	  || con_handle->deferred_close_handle_count >=
+	  DEFERRED_CLOSE_HANDLE_ALLOC_SIZE)
+	{
+	  goto send_close_handle_msg;
+	}
     }
 
   if (con_handle->deferred_close_handle_count == 0 &&
@@ -1458,7 +1439,7 @@ qe_send_close_handle_msg (T_CON_HANDLE * con_handle, int server_handle_id)
   char func_code = CAS_FC_CLOSE_REQ_HANDLE;
   char autocommit_flag;
 
-  net_buf_init (&net_buf);
+  net_buf_init_spare (&net_buf, &con_handle->send_buf);
 
   net_buf_cp_str (&net_buf, &func_code, 1);
   ADD_ARG_INT (&net_buf, server_handle_id);
@@ -1468,12 +1449,12 @@ qe_send_close_handle_msg (T_CON_HANDLE * con_handle, int server_handle_id)
   if (net_buf.err_code < 0)
     {
       err_code = net_buf.err_code;
-      net_buf_clear (&net_buf);
+      net_buf_clear_spare (&net_buf, &con_handle->send_buf);
       return err_code;
     }
 
   err_code = net_send_msg (con_handle, net_buf.data, net_buf.data_size);
-  net_buf_clear (&net_buf);
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
   if (err_code < 0)
     {
       if (con_handle->con_status == CCI_CON_STATUS_OUT_TRAN)
@@ -1594,7 +1575,7 @@ qe_cursor (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, int offset,
   else
     return CCI_ER_INVALID_CURSOR_POS;
 
-  net_buf_init (&net_buf);
+  net_buf_init_spare (&net_buf, &con_handle->send_buf);
   net_buf_cp_str (&net_buf, &func_code, 1);
   ADD_ARG_INT (&net_buf, req_handle->server_handle_id);
   ADD_ARG_INT (&net_buf, cursor_pos);
@@ -1611,7 +1592,7 @@ qe_cursor (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, int offset,
     {
       goto cursor_error;
     }
-  net_buf_clear (&net_buf);
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
 
   err_code = net_recv_msg (con_handle, &result_msg, &result_msg_size,
 			   err_buf);
@@ -1629,12 +1610,12 @@ qe_cursor (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, int offset,
 
   if (result_msg_size < NET_SIZE_INT)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return CCI_ER_COMMUNICATION;
     }
   NET_STR_TO_INT (tuple_num, cur_p);
   req_handle->num_tuple = tuple_num;
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   if (origin == CCI_CURSOR_FIRST)
     {
@@ -1660,7 +1641,7 @@ qe_cursor (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, int offset,
   return 0;
 
 cursor_error:
-  net_buf_clear (&net_buf);
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
   return err_code;
 }
 
@@ -1701,36 +1682,61 @@ qe_fetch (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, char flag,
 	      return CCI_ER_DELETED_TUPLE;
 	    }
 	}
+      if (flag == 0 && result_set_index == 0
+	  && req_handle->cursor_pos == req_handle->fetched_tuple_begin)
+	{
+	  read_ahead_fetch (req_handle, con_handle);
+	}
       return 0;
     }
 
-  hm_req_handle_fetch_buf_free (req_handle);
-
-  net_buf_init (&net_buf);
-  net_buf_cp_str (&net_buf, &func_code, 1);
-  ADD_ARG_INT (&net_buf, req_handle->server_handle_id);
-  ADD_ARG_INT (&net_buf, req_handle->cursor_pos);
-  ADD_ARG_INT (&net_buf, req_handle->fetch_size);
-  ADD_ARG_BYTES (&net_buf, &flag, 1);
-  ADD_ARG_INT (&net_buf, result_set_index);
-
-  if (net_buf.err_code < 0)
+  if (req_handle->read_ahead_state != READ_AHEAD_NONE
+      && req_handle->read_ahead_pos == req_handle->cursor_pos
+      && flag == 0 && result_set_index == 0)
     {
-      err_code = net_buf.err_code;
-      net_buf_clear (&net_buf);
-      return err_code;
+      if (req_handle->read_ahead_state == READ_AHEAD_SENT)
+	{
+	  net_recv_read_ahead (con_handle);
+	}
+      if (req_handle->read_ahead_state == READ_AHEAD_RECEIVED)
+	{
+	  result_msg = req_handle->read_ahead_msg;
+	  result_msg_size = req_handle->read_ahead_msg_size;
+	  req_handle->read_ahead_msg = NULL;
+	  req_handle->read_ahead_state = READ_AHEAD_NONE;
+	}
     }
 
-  err_code = net_send_msg (con_handle, net_buf.data, net_buf.data_size);
-  net_buf_clear (&net_buf);
-  if (err_code < 0)
-    return err_code;
+  hm_req_handle_fetch_buf_free (req_handle);
 
-  err_code = net_recv_msg (con_handle, &result_msg, &result_msg_size,
-			   err_buf);
-  if (err_code < 0)
+  if (result_msg == NULL)
     {
-      return err_code;
+      net_buf_init_spare (&net_buf, &con_handle->send_buf);
+      net_buf_cp_str (&net_buf, &func_code, 1);
+      ADD_ARG_INT (&net_buf, req_handle->server_handle_id);
+      ADD_ARG_INT (&net_buf, req_handle->cursor_pos);
+      ADD_ARG_INT (&net_buf, req_handle->fetch_size);
+      ADD_ARG_BYTES (&net_buf, &flag, 1);
+      ADD_ARG_INT (&net_buf, result_set_index);
+
+      if (net_buf.err_code < 0)
+	{
+	  err_code = net_buf.err_code;
+	  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
+	  return err_code;
+	}
+
+      err_code = net_send_msg (con_handle, net_buf.data, net_buf.data_size);
+      net_buf_clear_spare (&net_buf, &con_handle->send_buf);
+      if (err_code < 0)
+	return err_code;
+
+      err_code = net_recv_msg (con_handle, &result_msg, &result_msg_size,
+			       err_buf);
+      if (err_code < 0)
+	{
+	  return err_code;
+	}
     }
 
   num_tuple = decode_fetch_result (con_handle,
@@ -1739,10 +1745,15 @@ qe_fetch (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, char flag,
 				   result_msg + 4, result_msg_size - 4);
   if (num_tuple < 0)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return num_tuple;
     }
 
+  if (req_handle->fetch_size_budget > 0)
+    {
+      adjust_fetch_size (req_handle, result_msg_size, num_tuple);
+    }
+
   if (num_tuple != 0)
     {
       if (flag)
@@ -1752,6 +1763,10 @@ qe_fetch (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle, char flag,
 	      return CCI_ER_DELETED_TUPLE;
 	    }
 	}
+      else if (result_set_index == 0)
+	{
+	  read_ahead_fetch (req_handle, con_handle);
+	}
     }
   else
     {
@@ -1953,7 +1968,7 @@ qe_schema_info (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 
   err_code =
     schema_info_decode (result_msg + 4, result_msg_size - 4, req_handle);
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
   if (err_code < 0)
     return err_code;
 
@@ -2017,7 +2032,7 @@ qe_oid_get (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 			 con_handle);
   if (err_code < 0)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return err_code;
     }
 
@@ -2152,7 +2167,7 @@ qe_oid_put2 (T_CON_HANDLE * con_handle, char *oid_str, char **attr_name,
 	      err_code = bind_value_conversion (CCI_A_TYPE_SET,
 						CCI_U_TYPE_SEQUENCE,
 						CCI_BIND_PTR,
-						new_val[i], &tmp_cell);
+						new_val[i], -1, &tmp_cell);
 	      if (err_code < 0)
 		{
 		  net_buf_clear (&net_buf);
@@ -2250,7 +2265,7 @@ qe_get_db_version (T_CON_HANDLE * con_handle, char *out_buf, int buf_size)
 	}
     }
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   return err_code;
 }
@@ -2314,7 +2329,7 @@ qe_get_class_num_objs (T_CON_HANDLE * con_handle, char *class_name, char flag,
 	}
     }
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   return err_code;
 }
@@ -2369,7 +2384,7 @@ qe_oid_cmd (T_CON_HANDLE * con_handle, char cmd, char *oid_str, char *out_buf,
 	}
     }
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   return err_code;
 }
@@ -2428,7 +2443,7 @@ qe_col_get (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 			 col_type, req_handle, con_handle);
   if (err_code < 0)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return err_code;
     }
 
@@ -2472,7 +2487,7 @@ qe_get_row_count (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 
   if (result_msg_size < 4)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return CCI_ER_COMMUNICATION;
     }
 
@@ -2531,7 +2546,7 @@ qe_get_last_insert_id (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 
   if (result_msg_size < 4)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return CCI_ER_COMMUNICATION;
     }
 
@@ -2546,7 +2561,7 @@ qe_get_last_insert_id (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
        * CCI_ER_NO_ERROR with NULL value
        * means DB NULL
        */
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return CCI_ER_NO_ERROR;
     }
 
@@ -2557,7 +2572,7 @@ qe_get_last_insert_id (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
   type = *ptr;
   if (type != CCI_U_TYPE_NUMERIC)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return CCI_ER_COMMUNICATION;
     }
 
@@ -2571,7 +2586,7 @@ qe_get_last_insert_id (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
       if (con_handle->last_insert_id == NULL)
 	{
 	  err_code = CCI_ER_NO_MORE_MEMORY;
-	  FREE_MEM (result_msg);
+	  FREE_MSG_BUF (result_msg);
 	  return err_code;
 	}
     }
@@ -2584,7 +2599,7 @@ qe_get_last_insert_id (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 
   *((char **) value) = con_handle->last_insert_id;
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
   return err_code;
 }
 
@@ -2639,7 +2654,7 @@ qe_col_size (T_CON_HANDLE * con_handle, char *oid_str, const char *col_attr,
 
   if (result_msg_size < 4)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return CCI_ER_COMMUNICATION;
     }
 
@@ -2647,7 +2662,7 @@ qe_col_size (T_CON_HANDLE * con_handle, char *oid_str, const char *col_attr,
     {
       NET_STR_TO_INT (*set_size, result_msg + 4);
     }
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   return 0;
 }
@@ -2772,7 +2787,7 @@ qe_next_result (T_REQ_HANDLE * req_handle, char flag,
   char *result_msg = NULL;
   int result_msg_size;
 
-  net_buf_init (&net_buf);
+  net_buf_init_spare (&net_buf, &con_handle->send_buf);
 
   net_buf_cp_str (&net_buf, &func_code, 1);
 
@@ -2782,12 +2797,12 @@ qe_next_result (T_REQ_HANDLE * req_handle, char flag,
   if (net_buf.err_code < 0)
     {
       err_code = net_buf.err_code;
-      net_buf_clear (&net_buf);
+      net_buf_clear_spare (&net_buf, &con_handle->send_buf);
       return err_code;
     }
 
   err_code = net_send_msg (con_handle, net_buf.data, net_buf.data_size);
-  net_buf_clear (&net_buf);
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
   if (err_code < 0)
     {
       return err_code;
@@ -2805,7 +2820,7 @@ qe_next_result (T_REQ_HANDLE * req_handle, char flag,
   err_code =
     next_result_info_decode (result_msg + 4, result_msg_size - 4, req_handle);
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   req_handle->cursor_pos = 0;
 
@@ -2830,7 +2845,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
   int shard_id;
   T_BROKER_VERSION broker_ver;
 
-  net_buf_init (&net_buf);
+  net_buf_init_spare (&net_buf, &con_handle->send_buf);
 
   net_buf_cp_str (&net_buf, &func_code, 1);
 
@@ -2845,7 +2860,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 	  remaining_time -= get_elapsed_time (&con_handle->start_time);
 	  if (remaining_time <= 0)
 	    {
-	      net_buf_clear (&net_buf);
+	      net_buf_clear_spare (&net_buf, &con_handle->send_buf);
 	      return CCI_ER_QUERY_TIMEOUT;
 	    }
 	}
@@ -2855,6 +2870,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
   autocommit_flag = (char) con_handle->autocommit_mode;
   ADD_ARG_BYTES (&net_buf, &autocommit_flag, 1);
 
+  net_buf_reserve (&net_buf, bind_value_size_hint (req_handle, true));
   for (row = 0; row < req_handle->bind_array_size; row++)
     {
       for (idx = 0; idx < req_handle->num_bind; idx++)
@@ -2887,7 +2903,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 		    value = (char **) req_handle->bind_value[idx].value;
 		    err_code =
 		      bind_value_conversion ((T_CCI_A_TYPE) a_type, u_type,
-					     CCI_BIND_PTR, value[row],
+					     CCI_BIND_PTR, value[row], -1,
 					     &cur_cell);
 		  }
 		  break;
@@ -2897,7 +2913,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 		    value = (INT64 *) req_handle->bind_value[idx].value;
 		    err_code =
 		      bind_value_conversion ((T_CCI_A_TYPE) a_type, u_type,
-					     CCI_BIND_PTR, &(value[row]),
+					     CCI_BIND_PTR, &(value[row]), -1,
 					     &cur_cell);
 		  }
 		  break;
@@ -2907,7 +2923,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 		    value = (int *) req_handle->bind_value[idx].value;
 		    err_code =
 		      bind_value_conversion ((T_CCI_A_TYPE) a_type, u_type,
-					     CCI_BIND_PTR, &(value[row]),
+					     CCI_BIND_PTR, &(value[row]), -1,
 					     &cur_cell);
 		  }
 		  break;
@@ -2917,7 +2933,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 		    value = (float *) req_handle->bind_value[idx].value;
 		    err_code =
 		      bind_value_conversion ((T_CCI_A_TYPE) a_type, u_type,
-					     CCI_BIND_PTR, &(value[row]),
+					     CCI_BIND_PTR, &(value[row]), -1,
 					     &cur_cell);
 		  }
 		  break;
@@ -2927,7 +2943,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 		    value = (double *) req_handle->bind_value[idx].value;
 		    err_code =
 		      bind_value_conversion ((T_CCI_A_TYPE) a_type, u_type,
-					     CCI_BIND_PTR, &(value[row]),
+					     CCI_BIND_PTR, &(value[row]), -1,
 					     &cur_cell);
 		  }
 		  break;
@@ -2937,7 +2953,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 		    value = (T_CCI_BIT *) req_handle->bind_value[idx].value;
 		    err_code =
 		      bind_value_conversion ((T_CCI_A_TYPE) a_type, u_type,
-					     CCI_BIND_PTR, &(value[row]),
+					     CCI_BIND_PTR, &(value[row]), -1,
 					     &cur_cell);
 		  }
 		  break;
@@ -2947,7 +2963,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 		    value = (T_CCI_DATE *) req_handle->bind_value[idx].value;
 		    err_code =
 		      bind_value_conversion ((T_CCI_A_TYPE) a_type, u_type,
-					     CCI_BIND_PTR, &(value[row]),
+					     CCI_BIND_PTR, &(value[row]), -1,
 					     &cur_cell);
 		  }
 		  break;
@@ -2957,7 +2973,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 		    value = (T_SET **) req_handle->bind_value[idx].value;
 		    err_code =
 		      bind_value_conversion ((T_CCI_A_TYPE) a_type, u_type,
-					     CCI_BIND_PTR, value[row],
+					     CCI_BIND_PTR, value[row], -1,
 					     &cur_cell);
 		  }
 		  break;
@@ -2968,7 +2984,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 		    value = req_handle->bind_value[idx].value;
 		    err_code =
 		      bind_value_conversion ((T_CCI_A_TYPE) a_type, u_type,
-					     CCI_BIND_PTR, value[row],
+					     CCI_BIND_PTR, value[row], -1,
 					     &cur_cell);
 		  }
 		  break;
@@ -2977,7 +2993,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 		}		/* end of switch */
 	      if (err_code < 0)
 		{
-		  net_buf_clear (&net_buf);
+		  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
 		  return err_code;
 		}
 	    }
@@ -2994,7 +3010,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
   if (net_buf.err_code < 0)
     {
       err_code = net_buf.err_code;
-      net_buf_clear (&net_buf);
+      net_buf_clear_spare (&net_buf, &con_handle->send_buf);
       return err_code;
     }
 
@@ -3004,13 +3020,13 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
       remaining_time -= get_elapsed_time (&con_handle->start_time);
       if (remaining_time <= 0)
 	{
-	  net_buf_clear (&net_buf);
+	  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
 	  return CCI_ER_QUERY_TIMEOUT;
 	}
     }
 
   err_code = net_send_msg (con_handle, net_buf.data, net_buf.data_size);
-  net_buf_clear (&net_buf);
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
   if (err_code < 0)
     {
       return err_code;
@@ -3039,7 +3055,7 @@ qe_execute_array (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
       req_handle->shard_id = shard_id;
     }
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
   return err_code;
 }
 
@@ -3137,7 +3153,7 @@ qe_cursor_update (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 
       err_code =
 	bind_value_conversion (a_type, (T_CCI_U_TYPE) u_type, CCI_BIND_PTR,
-			       value, &bind_value);
+			       value, -1, &bind_value);
       if (err_code < 0)
 	{
 	  net_buf_clear (&net_buf);
@@ -3189,7 +3205,7 @@ qe_execute_batch (T_CON_HANDLE * con_handle, int num_query, char **sql_stmt,
   int shard_id;
   T_BROKER_VERSION broker_ver;
 
-  net_buf_init (&net_buf);
+  net_buf_init_spare (&net_buf, &con_handle->send_buf);
 
   net_buf_cp_str (&net_buf, &func_code, 1);
 
@@ -3206,7 +3222,7 @@ qe_execute_batch (T_CON_HANDLE * con_handle, int num_query, char **sql_stmt,
 	  remaining_time -= get_elapsed_time (&con_handle->start_time);
 	  if (remaining_time <= 0)
 	    {
-	      net_buf_clear (&net_buf);
+	      net_buf_clear_spare (&net_buf, &con_handle->send_buf);
 	      return CCI_ER_QUERY_TIMEOUT;
 	    }
 	}
@@ -3222,7 +3238,7 @@ qe_execute_batch (T_CON_HANDLE * con_handle, int num_query, char **sql_stmt,
   if (net_buf.err_code < 0)
     {
       err_code = net_buf.err_code;
-      net_buf_clear (&net_buf);
+      net_buf_clear_spare (&net_buf, &con_handle->send_buf);
       return err_code;
     }
 
@@ -3232,13 +3248,13 @@ qe_execute_batch (T_CON_HANDLE * con_handle, int num_query, char **sql_stmt,
       remaining_time -= get_elapsed_time (&con_handle->start_time);
       if (remaining_time <= 0)
 	{
-	  net_buf_clear (&net_buf);
+	  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
 	  return CCI_ER_QUERY_TIMEOUT;
 	}
     }
 
   err_code = net_send_msg (con_handle, net_buf.data, net_buf.data_size);
-  net_buf_clear (&net_buf);
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
   if (err_code < 0)
     {
       return err_code;
@@ -3267,7 +3283,7 @@ qe_execute_batch (T_CON_HANDLE * con_handle, int num_query, char **sql_stmt,
       con_handle->shard_id = shard_id;
     }
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   return err_code;
 }
@@ -3801,7 +3817,7 @@ qe_get_data_req_handle (T_CON_HANDLE * con_handle, T_REQ_HANDLE * req_handle,
 
   if (result_msg != NULL)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
     }
 
   map_open_ots (statement_id, &out_req_handle->mapped_stmt_id);
@@ -3812,7 +3828,7 @@ qe_get_data_req_handle (T_CON_HANDLE * con_handle, T_REQ_HANDLE * req_handle,
 get_data_error:
   if (result_msg != NULL)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
     }
 
   if (out_req_handle != NULL)
@@ -3881,7 +3897,7 @@ qe_get_attr_type_str (T_CON_HANDLE * con_handle, char *class_name,
       buf[buf_size] = '\0';
     }
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   return err_code;
 }
@@ -3933,14 +3949,14 @@ qe_get_query_info (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
       tmp_buf = (char *) MALLOC (result_msg_size - 4);
       if (tmp_buf == NULL)
 	{
-	  FREE_MEM (result_msg);
+	  FREE_MSG_BUF (result_msg);
 	  return CCI_ER_NO_MORE_MEMORY;
 	}
       memcpy (tmp_buf, result_msg + 4, result_msg_size - 4);
       *out_buf = tmp_buf;
     }
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   return err_code;
 }
@@ -4037,7 +4053,7 @@ qe_get_param_info (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle,
 	}
     }
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   return num_param;
 }
@@ -4129,7 +4145,7 @@ qe_xa_recover (T_CON_HANDLE * con_handle, XID * xid, int num_xid,
   res =
     xa_prepare_info_decode (result_msg + 4, result_msg_size - 4, res, xid,
 			    num_xid);
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
   return res;
 }
 
@@ -4217,7 +4233,7 @@ qe_lob_new (T_CON_HANDLE * con_handle, T_LOB ** lob,
   new_lob = (T_LOB *) MALLOC (sizeof (T_LOB));
   if (new_lob == NULL)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return CCI_ER_NO_MORE_MEMORY;
     }
 
@@ -4226,7 +4242,7 @@ qe_lob_new (T_CON_HANDLE * con_handle, T_LOB ** lob,
   new_lob->handle = (char *) MALLOC (new_lob->handle_size);
   if (new_lob->handle == NULL)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       FREE_MEM (new_lob);
       return CCI_ER_NO_MORE_MEMORY;
     }
@@ -4235,7 +4251,7 @@ qe_lob_new (T_CON_HANDLE * con_handle, T_LOB ** lob,
 
   if (result_msg_size < NET_SIZE_INT + new_lob->handle_size)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       FREE_MEM (new_lob->handle);
       FREE_MEM (new_lob);
       return CCI_ER_COMMUNICATION;
@@ -4243,7 +4259,7 @@ qe_lob_new (T_CON_HANDLE * con_handle, T_LOB ** lob,
 
   *lob = new_lob;
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
   return CCI_ER_NO_ERROR;
 }
 
@@ -4289,7 +4305,7 @@ qe_lob_write (T_CON_HANDLE * con_handle, T_LOB * lob,
 
   if (result_msg_size < NET_SIZE_INT || bytes_written > length)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return CCI_ER_COMMUNICATION;
     }
 
@@ -4299,7 +4315,7 @@ qe_lob_write (T_CON_HANDLE * con_handle, T_LOB * lob,
       t_lob_set_size (lob, start_pos + bytes_written);
     }
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
   return bytes_written;
 }
 
@@ -4343,7 +4359,7 @@ qe_lob_read (T_CON_HANDLE * con_handle, T_LOB * lob,
 
   if (result_msg_size < NET_SIZE_INT || bytes_read > length)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return CCI_ER_COMMUNICATION;
     }
 
@@ -4352,7 +4368,7 @@ qe_lob_read (T_CON_HANDLE * con_handle, T_LOB * lob,
       memcpy (buf, result_msg + 4, bytes_read);
     }
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
   return bytes_read;
 }
 
@@ -4393,7 +4409,7 @@ qe_get_shard_info (T_CON_HANDLE * con_handle, T_CCI_SHARD_INFO ** shard_info,
     net_recv_msg (con_handle, &result_msg, &result_msg_size, err_buf);
   if (num_shard < 0)
     {
-      FREE_MEM (result_msg);
+      FREE_MSG_BUF (result_msg);
       return num_shard;
     }
 
@@ -4409,7 +4425,7 @@ qe_get_shard_info (T_CON_HANDLE * con_handle, T_CCI_SHARD_INFO ** shard_info,
 	}
     }
 
-  FREE_MEM (result_msg);
+  FREE_MSG_BUF (result_msg);
 
   return num_shard;
 }
@@ -5486,7 +5502,7 @@ next_result_info_decode (char *buf, int size, T_REQ_HANDLE * req_handle)
 
 static int
 bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
-		       void *value, T_BIND_VALUE * bind_value)
+		       void *value, int length, T_BIND_VALUE * bind_value)
 {
   int err_code;
 
@@ -5500,19 +5516,20 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	case CCI_U_TYPE_VARNCHAR:
 	case CCI_U_TYPE_NUMERIC:
 	case CCI_U_TYPE_ENUM:
+	  if (length < 0)
+	    {
+	      length = strlen ((char *) value);
+	    }
+	  bind_value->size = length + 1;
 	  if (flag == CCI_BIND_PTR)
 	    {
 	      bind_value->value = value;
 	      bind_value->flag = BIND_PTR_STATIC;
 	    }
-	  else
+	  else if (bind_value_copy_str (bind_value, value, length) < 0)
 	    {
-	      ALLOC_COPY (bind_value->value, value);
-	      if (bind_value->value == NULL)
-		return CCI_ER_NO_MORE_MEMORY;
-	      bind_value->flag = BIND_PTR_DYNAMIC;
+	      return CCI_ER_NO_MORE_MEMORY;
 	    }
-	  bind_value->size = strlen ((char *) value) + 1;
 	  break;
 	case CCI_U_TYPE_BIGINT:
 	  {
@@ -5521,11 +5538,8 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	    err_code = ut_str_to_bigint ((char *) value, &bi_val);
 	    if (err_code < 0)
 	      return err_code;
-	    ALLOC_COPY_BIGINT (bind_value->value, bi_val);
-	    if (bind_value->value == NULL)
-	      return CCI_ER_NO_MORE_MEMORY;
+	    BIND_VALUE_SET_INLINE (bind_value, bi, bi_val);
 	    bind_value->size = sizeof (INT64);
-	    bind_value->flag = BIND_PTR_DYNAMIC;
 	  }
 	  break;
 
@@ -5537,11 +5551,8 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	    err_code = ut_str_to_int ((char *) value, &i_val);
 	    if (err_code < 0)
 	      return err_code;
-	    ALLOC_COPY_INT (bind_value->value, i_val);
-	    if (bind_value->value == NULL)
-	      return CCI_ER_NO_MORE_MEMORY;
+	    BIND_VALUE_SET_INLINE (bind_value, i, i_val);
 	    bind_value->size = sizeof (int);
-	    bind_value->flag = BIND_PTR_DYNAMIC;
 	  }
 	  break;
 	case CCI_U_TYPE_FLOAT:
@@ -5551,11 +5562,8 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	    err_code = ut_str_to_float ((char *) value, &f_val);
 	    if (err_code < 0)
 	      return err_code;
-	    ALLOC_COPY_FLOAT (bind_value->value, f_val);
-	    if (bind_value->value == NULL)
-	      return CCI_ER_NO_MORE_MEMORY;
+	    BIND_VALUE_SET_INLINE (bind_value, f, f_val);
 	    bind_value->size = sizeof (float);
-	    bind_value->flag = BIND_PTR_DYNAMIC;
 	  }
 	  break;
 	case CCI_U_TYPE_MONETARY:
@@ -5565,11 +5573,8 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	    err_code = ut_str_to_double ((char *) value, &d_val);
 	    if (err_code < 0)
 	      return err_code;
-	    ALLOC_COPY_DOUBLE (bind_value->value, d_val);
-	    if (bind_value->value == NULL)
-	      return CCI_ER_NO_MORE_MEMORY;
+	    BIND_VALUE_SET_INLINE (bind_value, d, d_val);
 	    bind_value->size = sizeof (double);
-	    bind_value->flag = BIND_PTR_DYNAMIC;
 	  }
 	  break;
 	case CCI_U_TYPE_DATE:
@@ -5578,11 +5583,8 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	    err_code = ut_str_to_date ((char *) value, &date);
 	    if (err_code < 0)
 	      return err_code;
-	    ALLOC_COPY_DATE (bind_value->value, date);
-	    if (bind_value->value == NULL)
-	      return CCI_ER_NO_MORE_MEMORY;
+	    BIND_VALUE_SET_INLINE (bind_value, date, date);
 	    bind_value->size = sizeof (T_CCI_DATE);
-	    bind_value->flag = BIND_PTR_DYNAMIC;
 	  }
 	  break;
 	case CCI_U_TYPE_TIME:
@@ -5591,11 +5593,8 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	    err_code = ut_str_to_time ((char *) value, &date);
 	    if (err_code < 0)
 	      return err_code;
-	    ALLOC_COPY_DATE (bind_value->value, date);
-	    if (bind_value->value == NULL)
-	      return CCI_ER_NO_MORE_MEMORY;
+	    BIND_VALUE_SET_INLINE (bind_value, date, date);
 	    bind_value->size = sizeof (T_CCI_DATE);
-	    bind_value->flag = BIND_PTR_DYNAMIC;
 	  }
 	  break;
 	case CCI_U_TYPE_TIMESTAMP:
@@ -5604,11 +5603,8 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	    err_code = ut_str_to_timestamp ((char *) value, &date);
 	    if (err_code < 0)
 	      return err_code;
-	    ALLOC_COPY_DATE (bind_value->value, date);
-	    if (bind_value->value == NULL)
-	      return CCI_ER_NO_MORE_MEMORY;
+	    BIND_VALUE_SET_INLINE (bind_value, date, date);
 	    bind_value->size = sizeof (T_CCI_DATE);
-	    bind_value->flag = BIND_PTR_DYNAMIC;
 	  }
 	  break;
 	case CCI_U_TYPE_DATETIME:
@@ -5617,11 +5613,8 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	    err_code = ut_str_to_datetime ((char *) value, &date);
 	    if (err_code < 0)
 	      return err_code;
-	    ALLOC_COPY_DATE (bind_value->value, date);
-	    if (bind_value->value == NULL)
-	      return CCI_ER_NO_MORE_MEMORY;
+	    BIND_VALUE_SET_INLINE (bind_value, date, date);
 	    bind_value->size = sizeof (T_CCI_DATE);
-	    bind_value->flag = BIND_PTR_DYNAMIC;
 	  }
 	  break;
 	case CCI_U_TYPE_OBJECT:
@@ -5630,10 +5623,7 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	    err_code = ut_str_to_oid ((char *) value, &obj);
 	    if (err_code < 0)
 	      return err_code;
-	    ALLOC_COPY_OBJECT (bind_value->value, obj);
-	    if (bind_value->value == NULL)
-	      return CCI_ER_NO_MORE_MEMORY;
-	    bind_value->flag = BIND_PTR_DYNAMIC;
+	    BIND_VALUE_SET_INLINE (bind_value, obj, obj);
 	  }
 	  break;
 	case CCI_U_TYPE_SET:
@@ -5661,38 +5651,28 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	  {
 	    char buf[64];
 	    ut_int_to_str (i_value, buf, 64);
-	    ALLOC_COPY (bind_value->value, buf);
-	    if (bind_value->value == NULL)
+	    if (bind_value_copy (bind_value, buf, strlen (buf) + 1) < 0)
 	      return CCI_ER_NO_MORE_MEMORY;
 	    bind_value->size = strlen (buf) + 1;
 	  }
 	  break;
 	case CCI_U_TYPE_BIGINT:
-	  ALLOC_COPY_BIGINT (bind_value->value, i_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, bi, i_value);
 	  break;
 	case CCI_U_TYPE_INT:
 	case CCI_U_TYPE_SHORT:
-	  ALLOC_COPY_INT (bind_value->value, i_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, i, i_value);
 	  break;
 	case CCI_U_TYPE_MONETARY:
 	case CCI_U_TYPE_DOUBLE:
-	  ALLOC_COPY_DOUBLE (bind_value->value, (double) i_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, d, (double) i_value);
 	  break;
 	case CCI_U_TYPE_FLOAT:
-	  ALLOC_COPY_FLOAT (bind_value->value, (float) i_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, f, (float) i_value);
 	  break;
 	default:
 	  return CCI_ER_TYPE_CONVERSION;
 	}
-      bind_value->flag = BIND_PTR_DYNAMIC;
     }
   else if (a_type == CCI_A_TYPE_BIGINT)
     {
@@ -5711,38 +5691,28 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	  {
 	    char buf[64];
 	    ut_int_to_str (bi_value, buf, 64);
-	    ALLOC_COPY (bind_value->value, buf);
-	    if (bind_value->value == NULL)
+	    if (bind_value_copy (bind_value, buf, strlen (buf) + 1) < 0)
 	      return CCI_ER_NO_MORE_MEMORY;
 	    bind_value->size = strlen (buf) + 1;
 	  }
 	  break;
 	case CCI_U_TYPE_BIGINT:
-	  ALLOC_COPY_BIGINT (bind_value->value, bi_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, bi, bi_value);
 	  break;
 	case CCI_U_TYPE_INT:
 	case CCI_U_TYPE_SHORT:
-	  ALLOC_COPY_INT (bind_value->value, (int) bi_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, i, (int) bi_value);
 	  break;
 	case CCI_U_TYPE_MONETARY:
 	case CCI_U_TYPE_DOUBLE:
-	  ALLOC_COPY_DOUBLE (bind_value->value, (double) bi_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, d, (double) bi_value);
 	  break;
 	case CCI_U_TYPE_FLOAT:
-	  ALLOC_COPY_FLOAT (bind_value->value, (float) bi_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, f, (float) bi_value);
 	  break;
 	default:
 	  return CCI_ER_TYPE_CONVERSION;
 	}
-      bind_value->flag = BIND_PTR_DYNAMIC;
     }
   else if (a_type == CCI_A_TYPE_FLOAT)
     {
@@ -5761,38 +5731,28 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	  {
 	    char buf[256];
 	    ut_float_to_str (f_value, buf, 256);
-	    ALLOC_COPY (bind_value->value, buf);
-	    if (bind_value->value == NULL)
+	    if (bind_value_copy (bind_value, buf, strlen (buf) + 1) < 0)
 	      return CCI_ER_NO_MORE_MEMORY;
 	    bind_value->size = strlen (buf) + 1;
 	  }
 	  break;
 	case CCI_U_TYPE_BIGINT:
-	  ALLOC_COPY_BIGINT (bind_value->value, (INT64) f_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, bi, (INT64) f_value);
 	  break;
 	case CCI_U_TYPE_INT:
 	case CCI_U_TYPE_SHORT:
-	  ALLOC_COPY_INT (bind_value->value, (int) f_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, i, (int) f_value);
 	  break;
 	case CCI_U_TYPE_MONETARY:
 	case CCI_U_TYPE_DOUBLE:
-	  ALLOC_COPY_DOUBLE (bind_value->value, (double) f_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, d, (double) f_value);
 	  break;
 	case CCI_U_TYPE_FLOAT:
-	  ALLOC_COPY_FLOAT (bind_value->value, f_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, f, f_value);
 	  break;
 	default:
 	  return CCI_ER_TYPE_CONVERSION;
 	}
-      bind_value->flag = BIND_PTR_DYNAMIC;
     }
   else if (a_type == CCI_A_TYPE_DOUBLE)
     {
@@ -5809,38 +5769,28 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	  {
 	    char buf[512];
 	    ut_double_to_str (d_value, buf, 512);
-	    ALLOC_COPY (bind_value->value, buf);
-	    if (bind_value->value == NULL)
+	    if (bind_value_copy (bind_value, buf, strlen (buf) + 1) < 0)
 	      return CCI_ER_NO_MORE_MEMORY;
 	    bind_value->size = strlen (buf) + 1;
 	  }
 	  break;
 	case CCI_U_TYPE_BIGINT:
-	  ALLOC_COPY_BIGINT (bind_value->value, (INT64) d_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, bi, (INT64) d_value);
 	  break;
 	case CCI_U_TYPE_INT:
 	case CCI_U_TYPE_SHORT:
-	  ALLOC_COPY_INT (bind_value->value, (int) d_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, i, (int) d_value);
 	  break;
 	case CCI_U_TYPE_MONETARY:
 	case CCI_U_TYPE_DOUBLE:
-	  ALLOC_COPY_DOUBLE (bind_value->value, d_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, d, d_value);
 	  break;
 	case CCI_U_TYPE_FLOAT:
-	  ALLOC_COPY_FLOAT (bind_value->value, (float) d_value);
-	  if (bind_value->value == NULL)
-	    return CCI_ER_NO_MORE_MEMORY;
+	  BIND_VALUE_SET_INLINE (bind_value, f, (float) d_value);
 	  break;
 	default:
 	  return CCI_ER_TYPE_CONVERSION;
 	}
-      bind_value->flag = BIND_PTR_DYNAMIC;
     }
   else if (a_type == CCI_A_TYPE_BIT)
     {
@@ -5856,13 +5806,10 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 		bind_value->value = bit_value->buf;
 		bind_value->flag = BIND_PTR_STATIC;
 	      }
-	    else
+	    else if (bind_value_copy (bind_value, bit_value->buf,
+				      bit_value->size) < 0)
 	      {
-		ALLOC_COPY_BIT (bind_value->value, bit_value->buf,
-				bit_value->size);
-		if (bind_value->value == NULL)
-		  return CCI_ER_NO_MORE_MEMORY;
-		bind_value->flag = BIND_PTR_DYNAMIC;
+		return CCI_ER_NO_MORE_MEMORY;
 	      }
 	    bind_value->size = bit_value->size;
 	  }
@@ -5906,11 +5853,8 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	case CCI_U_TYPE_TIMESTAMP:
 	case CCI_U_TYPE_DATETIME:
 	  {
-	    ALLOC_COPY_DATE (bind_value->value, *((T_CCI_DATE *) value));
-	    if (bind_value->value == NULL)
-	      return CCI_ER_NO_MORE_MEMORY;
+	    BIND_VALUE_SET_INLINE (bind_value, date, *((T_CCI_DATE *) value));
 	    bind_value->size = sizeof (T_CCI_DATE);
-	    bind_value->flag = BIND_PTR_DYNAMIC;
 	  }
 	  break;
 	default:
@@ -5924,10 +5868,11 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
 	case CCI_U_TYPE_BLOB:
 	case CCI_U_TYPE_CLOB:
 	  {
-	    ALLOC_COPY_BIT (bind_value->value, (T_LOB *) value,
-			    sizeof (T_LOB));
+	    if (bind_value_copy (bind_value, value, sizeof (T_LOB)) < 0)
+	      {
+		return CCI_ER_NO_MORE_MEMORY;
+	      }
 	    bind_value->size = sizeof (T_LOB);
-	    bind_value->flag = BIND_PTR_DYNAMIC;
 	  }
 	  break;
 	default:
@@ -5981,6 +5926,99 @@ bind_value_conversion (T_CCI_A_TYPE a_type, T_CCI_U_TYPE u_type, char flag,
   return 0;
 }
 
+/*
+ * bind_value_copy - copy size bytes of value into bind_value, in its inline
+ *   storage if they fit and on the heap otherwise.
+ */
+static int
+bind_value_copy (T_BIND_VALUE * bind_value, const void *value, int size)
+{
+  if (size <= (int) sizeof (bind_value->inline_value))
+    {
+      memcpy (&(bind_value->inline_value), value, size);
+      bind_value->value = &(bind_value->inline_value);
+      bind_value->flag = BIND_PTR_INLINE;
+      return 0;
+    }
+
+  bind_value->value = MALLOC (size);
+  if (bind_value->value == NULL)
+    {
+      return CCI_ER_NO_MORE_MEMORY;
+    }
+  memcpy (bind_value->value, value, size);
+  bind_value->flag = BIND_PTR_DYNAMIC;
+  return 0;
+}
+
+/*
+ * bind_value_copy_str - copy length bytes of str and a terminating NUL
+ *   into bind_value, like bind_value_copy.
+ */
+static int
+bind_value_copy_str (T_BIND_VALUE * bind_value, const char *str, int length)
+{
+  char *buf;
+
+  if (length < (int) sizeof (bind_value->inline_value))
+    {
+      buf = bind_value->inline_value.str;
+      bind_value->flag = BIND_PTR_INLINE;
+    }
+  else
+    {
+      buf = (char *) MALLOC (length + 1);
+      if (buf == NULL)
+	{
+	  return CCI_ER_NO_MORE_MEMORY;
+	}
+      bind_value->flag = BIND_PTR_DYNAMIC;
+    }
+
+  memcpy (buf, str, length);
+  buf[length] = '\0';
+  bind_value->value = buf;
+  return 0;
+}
+
+/*
+ * bind_value_size_hint - estimate the wire size of the bind values so
+ *   that the request buffer is sized once. The size of bind_param values
+ *   is known; bind array values are assumed BIND_ARRAY_WIDTH_HINT bytes
+ *   wide.
+ */
+static int
+bind_value_size_hint (T_REQ_HANDLE * req_handle, bool is_array)
+{
+  INT64 hint = 0;
+  int i;
+
+  if (!is_array)
+    {
+      for (i = 0; i < req_handle->num_bind; i++)
+	{
+	  hint += BIND_VALUE_NET_OVERHEAD + NET_SIZE_INT64;
+	  if (req_handle->bind_value[i].size > 0)
+	    {
+	      hint += req_handle->bind_value[i].size;
+	    }
+	}
+    }
+  else
+    {
+      hint = (INT64) req_handle->bind_array_size * req_handle->num_bind
+	* (BIND_VALUE_NET_OVERHEAD + BIND_ARRAY_WIDTH_HINT);
+    }
+
+  /* past this the geometric growth is cheap enough */
+  if (hint > NET_BUF_MAX_SPARE_SIZE)
+    {
+      hint = NET_BUF_MAX_SPARE_SIZE;
+    }
+
+  return (int) hint;
+}
+
 static int
 bind_value_to_net_buf (T_NET_BUF * net_buf, char u_type, void *value,
 		       int size, char *charset, bool set_default_value)
@@ -6015,7 +6053,15 @@ bind_value_to_net_buf (T_NET_BUF * net_buf, char u_type, void *value,
 	}
       else
 	{
+#if defined (WINDOWS) || defined (UNICODE_DATA)
 	  ADD_ARG_STR (net_buf, value, size, charset);
+#else
+	  /* a value bound by pointer with cci_bind_param_ex may hold NULs
+	   * and need not be terminated, so add the terminator here */
+	  net_buf_cp_int (net_buf, size);
+	  net_buf_cp_str (net_buf, (char *) value, size - 1);
+	  net_buf_cp_str (net_buf, "", 1);
+#endif
 	}
       break;
     case CCI_U_TYPE_NUMERIC:
@@ -6409,6 +6455,103 @@ decode_fetch_result (T_CON_HANDLE * con_handle, T_REQ_HANDLE * req_handle,
   return num_tuple;
 }
 
+/*
+ * Grow fetch_size geometrically while the observed tuple width says the
+ * next reply still fits in fetch_size_budget bytes, and shrink it at once
+ * when it would not.
+ */
+static void
+adjust_fetch_size (T_REQ_HANDLE * req_handle, int msg_size, int num_tuple)
+{
+  int tuple_size;
+  int max_fetch_size;
+
+  if (num_tuple <= 0)
+    {
+      return;
+    }
+
+  tuple_size = msg_size / num_tuple;
+  if (tuple_size <= 0)
+    {
+      tuple_size = 1;
+    }
+
+  max_fetch_size = req_handle->fetch_size_budget / tuple_size;
+  if (max_fetch_size > ADAPTIVE_FETCH_SIZE_MAX)
+    {
+      max_fetch_size = ADAPTIVE_FETCH_SIZE_MAX;
+    }
+  else if (max_fetch_size < 1)
+    {
+      max_fetch_size = 1;
+    }
+
+  if (req_handle->fetch_size < max_fetch_size / 2)
+    {
+      req_handle->fetch_size *= 2;
+    }
+  else
+    {
+      req_handle->fetch_size = max_fetch_size;
+    }
+}
+
+/*
+ * Send CAS_FC_FETCH for the block following the one just made current,
+ * without waiting for the reply. The reply is picked up by the next
+ * qe_fetch that leaves the current block, or by net_send_msg before any
+ * other request goes out on the connection.
+ * Only forward-only cursors (autocommit) are read ahead, since their next
+ * access is always the next block.
+ */
+static void
+read_ahead_fetch (T_REQ_HANDLE * req_handle, T_CON_HANDLE * con_handle)
+{
+  T_NET_BUF net_buf;
+  char func_code = CAS_FC_FETCH;
+  char flag = 0;
+  int next_pos;
+
+  if (!req_handle->read_ahead
+      || req_handle->read_ahead_state != READ_AHEAD_NONE
+      || con_handle->read_ahead_req_index != 0
+      || con_handle->autocommit_mode != CCI_AUTOCOMMIT_TRUE
+      || req_handle->stmt_type != CUBRID_STMT_SELECT
+      || is_connected_to_oracle (con_handle))
+    {
+      return;
+    }
+
+  next_pos = req_handle->fetched_tuple_end + 1;
+  if (req_handle->fetched_tuple_begin <= 0
+      || next_pos > req_handle->num_tuple)
+    {
+      return;
+    }
+
+  net_buf_init_spare (&net_buf, &con_handle->send_buf);
+  net_buf_cp_str (&net_buf, &func_code, 1);
+  ADD_ARG_INT (&net_buf, req_handle->server_handle_id);
+  ADD_ARG_INT (&net_buf, next_pos);
+  ADD_ARG_INT (&net_buf, req_handle->fetch_size);
+  ADD_ARG_BYTES (&net_buf, &flag, 1);
+  ADD_ARG_INT (&net_buf, 0);
+
+  if (net_buf.err_code < 0
+      || net_send_msg (con_handle, net_buf.data, net_buf.data_size) < 0)
+    {
+      net_buf_clear_spare (&net_buf, &con_handle->send_buf);
+      return;
+    }
+  net_buf_clear_spare (&net_buf, &con_handle->send_buf);
+
+  req_handle->read_ahead_state = READ_AHEAD_SENT;
+  req_handle->read_ahead_pos = next_pos;
+  con_handle->read_ahead_req_index = req_handle->req_handle_index;
+  con_handle->read_ahead_sock_fd = con_handle->sock_fd;
+}
+
 #ifdef CCI_XA
 static void
 add_arg_xid (T_NET_BUF * net_buf, XID * xid)
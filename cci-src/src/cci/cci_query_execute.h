@@ -60,6 +60,7 @@
 
 #define BIND_PTR_STATIC		0
 #define BIND_PTR_DYNAMIC	1
+#define BIND_PTR_INLINE		2	/* value points to inline_value */
 
 #define NET_STR_TO_INT64(INT64_VALUE, PTR)                              \
         do {                                                            \
@@ -317,7 +318,8 @@ extern void qe_bind_value_free (T_REQ_HANDLE * req_handle);
 extern int qe_bind_param (T_REQ_HANDLE * req_handle,
 			  int index,
 			  T_CCI_A_TYPE a_type,
-			  void *value, T_CCI_U_TYPE u_type, char flag);
+			  void *value, int length,
+			  T_CCI_U_TYPE u_type, char flag);
 extern int qe_execute (T_REQ_HANDLE * req_handle,
 		       T_CON_HANDLE * con_handle,
 		       char flag, int max_col_size, T_CCI_ERROR * err_buf);
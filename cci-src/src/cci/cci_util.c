@@ -47,9 +47,10 @@
 #ifdef WINDOWS
 #include <winsock2.h>
 #include <windows.h>
+#else
+#include <pthread.h>
 #endif
 #include <sys/types.h>
-#include <regex38a.h>
 
 /************************************************************************
  * OTHER IMPORTED HEADER FILES						*
@@ -68,6 +69,16 @@
 #define strtoll	_strtoi64
 #endif
 
+#define URL_PREFIX		"cci:cubrid"
+#define URL_CACHE_BUCKETS	64
+#define URL_CACHE_MAX_ENTRIES	256
+
+#define IS_URL_NAME_CHAR(c)				\
+	(((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z')	\
+	 || ((c) >= '0' && (c) <= '9') || (c) == '_')
+#define IS_URL_HOST_CHAR(c)				\
+	(IS_URL_NAME_CHAR (c) || (c) == '.' || (c) == '-')
+
 /************************************************************************
  * PRIVATE TYPE DEFINITIONS						*
  ************************************************************************/
@@ -81,9 +92,8 @@ static char *wstr2str (WCHAR * wstr, UINT CodePage);
 static WCHAR *str2wstr (char *str, UINT CodePage);
 #endif
 static char is_float_str (char *str);
-static void *cci_reg_malloc (void *dummy, size_t s);
-static void *cci_reg_realloc (void *dummy, void *p, size_t s);
-static void cci_reg_free (void *dummy, void *p);
+static int url_scan (const char *src, int offset[], int length[]);
+static unsigned int url_hash (const char *src);
 
 /************************************************************************
  * INTERFACE VARIABLES							*
@@ -97,6 +107,18 @@ static void cci_reg_free (void *dummy, void *p);
  * PRIVATE VARIABLES							*
  ************************************************************************/
 
+/* parsed connection urls, keyed by the url string. entries are immutable
+ * and live until the process exits; beyond URL_CACHE_MAX_ENTRIES urls
+ * are parsed into entries owned by the caller. */
+static T_URL_ENTRY *url_cache[URL_CACHE_BUCKETS];
+static int url_cache_count = 0;
+
+#if defined(WINDOWS)
+static HANDLE url_cache_mutex;
+#else
+static T_MUTEX url_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 /************************************************************************
  * IMPLEMENTATION OF INTERFACE FUNCTIONS 				*
  ************************************************************************/
@@ -659,105 +681,264 @@ is_float_str (char *str)
   return 0;
 }
 
-static void *
-cci_reg_malloc (void *dummy, size_t s)
+/*
+ * url_scan - match src against
+ *   cci:cubrid[-oracle|-mysql]:host:port:db:user:pass:[?name=value[&name=value]...]
+ * in a single pass and store where each of the MAX_URL_MATCH_COUNT fields
+ * starts and how long it is. The length of the properties is -1 when the
+ * url has none.
+ */
+static int
+url_scan (const char *src, int offset[], int length[])
 {
-  return cci_malloc (s);
-}
+  const char *p = src, *start;
+  int i;
 
-static void *
-cci_reg_realloc (void *dummy, void *p, size_t s)
-{
-  return cci_realloc (p, s);
+  if (strncasecmp (p, URL_PREFIX, sizeof (URL_PREFIX) - 1) != 0)
+    {
+      return CCI_ER_INVALID_URL;
+    }
+  p += sizeof (URL_PREFIX) - 1;
+
+  if (strncasecmp (p, "-oracle", 7) == 0)
+    {
+      p += 7;
+    }
+  else if (strncasecmp (p, "-mysql", 6) == 0)
+    {
+      p += 6;
+    }
+  if (*p != ':')
+    {
+      return CCI_ER_INVALID_URL;
+    }
+  p++;
+
+  /* host, port, dbname, user and password; only dbname may not be empty */
+  for (i = 0; i < MAX_URL_MATCH_COUNT - 1; i++)
+    {
+      for (start = p; *p != ':' && *p != '\0'; p++)
+	{
+	  if ((i == 0 && !IS_URL_HOST_CHAR (*p))
+	      || (i == 1 && (*p < '0' || *p > '9')))
+	    {
+	      return CCI_ER_INVALID_URL;
+	    }
+	}
+      if (*p != ':' || (i == 2 && p == start))
+	{
+	  return CCI_ER_INVALID_URL;
+	}
+      offset[i] = (int) (start - src);
+      length[i] = (int) (p - start);
+      p++;
+    }
+
+  offset[i] = (int) (p - src);
+  if (*p == '\0')
+    {
+      length[i] = -1;
+      return CCI_ER_NO_ERROR;
+    }
+  if (*p != '?')
+    {
+      return CCI_ER_INVALID_URL;
+    }
+
+  do
+    {
+      p++;			/* '?' or '&' */
+      for (start = p; IS_URL_NAME_CHAR (*p); p++)
+	;
+      if (p == start || *p != '=')
+	{
+	  return CCI_ER_INVALID_URL;
+	}
+      p++;
+      for (start = p; *p != '\0' && *p != '&' && *p != '=' && *p != '?';
+	   p++)
+	;
+      if (p == start)
+	{
+	  return CCI_ER_INVALID_URL;
+	}
+    }
+  while (*p == '&');
+
+  if (*p != '\0')
+    {
+      return CCI_ER_INVALID_URL;
+    }
+  length[i] = (int) (p - src) - offset[i];
+
+  return CCI_ER_NO_ERROR;
 }
 
-static void
-cci_reg_free (void *dummy, void *p)
+static unsigned int
+url_hash (const char *src)
 {
-  cci_free (p);
+  unsigned int hash = 2166136261U;
+
+  while (*src != '\0')
+    {
+      hash = (hash ^ (unsigned char) *src++) * 16777619U;
+    }
+
+  return hash;
 }
 
 int
 cci_url_match (const char *src, char *token[])
 {
-  static const char *pattern =
-    "cci:cubrid(-oracle|-mysql)?:([a-zA-Z_0-9\\.-]*):([0-9]*):([^:]+):([^:]*):([^:]*):(\\?[a-zA-Z_0-9]+=[^&=?]+(&[a-zA-Z_0-9]+=[^&=?]+)*)?";
-  static int match_idx[] = { 2, 3, 4, 5, 6, 7, -1 };
-
-  unsigned i, len;
-  int error;
-  cub_regex_t regex;
-  cub_regmatch_t match[100];
+  int offset[MAX_URL_MATCH_COUNT], length[MAX_URL_MATCH_COUNT];
+  int i, error;
 
-  char b[256];
+  for (i = 0; i < MAX_URL_MATCH_COUNT; i++)
+    {
+      token[i] = NULL;
+    }
 
-  cub_regset_malloc (cci_reg_malloc);
-  cub_regset_realloc (cci_reg_realloc);
-  cub_regset_free (cci_reg_free);
+  error = url_scan (src, offset, length);
+  if (error != CCI_ER_NO_ERROR)
+    {
+      return error;
+    }
 
-  error = cub_regcomp (&regex, pattern, CUB_REG_EXTENDED | CUB_REG_ICASE);
-  if (error != CUB_REG_OKAY)
+  for (i = 0; i < MAX_URL_MATCH_COUNT && length[i] >= 0; i++)
     {
-      /* should not reach on this */
-      cub_regerror (error, &regex, b, 256);
-      fprintf (stderr, "cub_regcomp : %s\n", b);
-      cub_regfree (&regex);
-      return CCI_ER_INVALID_URL;	/* pattern compilation error */
+      token[i] = MALLOC (length[i] + 1);
+      if (token[i] == NULL)
+	{
+	  /* free allocated memory when error was CCI_ER_NO_MORE_MEMORY */
+	  for (i = 0; i < MAX_URL_MATCH_COUNT; i++)
+	    {
+	      FREE_MEM (token[i]);
+	    }
+	  return CCI_ER_NO_MORE_MEMORY;
+	}
+      memcpy (token[i], src + offset[i], length[i]);
+      token[i][length[i]] = '\0';
     }
 
-  len = strlen (src);
-  error = cub_regexec (&regex, src, len, 100, match, 0);
-  if (error == CUB_REG_NOMATCH)
+  return CCI_ER_NO_ERROR;
+}
+
+void
+cci_url_cache_init (void)
+{
+#if defined(WINDOWS)
+  MUTEX_INIT (url_cache_mutex);
+#endif
+}
+
+/*
+ * cci_url_parse - look src up in the url cache, or match it and add it.
+ * The entry holds the same tokens as cci_url_match and must be given back
+ * with cci_url_release. Its tokens must not be modified.
+ */
+int
+cci_url_parse (const char *src, T_URL_ENTRY ** entry)
+{
+  int offset[MAX_URL_MATCH_COUNT], length[MAX_URL_MATCH_COUNT];
+  unsigned int hash, bucket;
+  size_t len;
+  T_URL_ENTRY *e, *new_entry;
+  char *p;
+  int i, error;
+
+  *entry = NULL;
+  hash = url_hash (src);
+  bucket = hash % URL_CACHE_BUCKETS;
+
+  MUTEX_LOCK (url_cache_mutex);
+  for (e = url_cache[bucket]; e != NULL; e = e->next)
     {
-      cub_regfree (&regex);
-      return CCI_ER_INVALID_URL;	/* invalid url */
+      if (e->hash == hash && strcmp (e->url, src) == 0)
+	{
+	  break;
+	}
     }
-  if (error != CUB_REG_OKAY)
+  MUTEX_UNLOCK (url_cache_mutex);
+
+  if (e != NULL)
     {
-      /* should not reach on this */
-      cub_regerror (error, &regex, b, 256);
-      fprintf (stderr, "cub_regcomp : %s\n", b);
-      cub_regfree (&regex);
-      return CCI_ER_INVALID_URL;	/* regexec error */
+      *entry = e;
+      return CCI_ER_NO_ERROR;
     }
 
-  if (match[0].rm_eo - match[0].rm_so != len)
+  error = url_scan (src, offset, length);
+  if (error != CCI_ER_NO_ERROR)
     {
-      cub_regfree (&regex);
-      return CCI_ER_INVALID_URL;	/* invalid url */
+      return error;
     }
 
-  for (i = 0; match_idx[i] != -1; i++)
+  /* the url and its tokens are copied after the entry in the same block */
+  len = strlen (src);
+  new_entry = (T_URL_ENTRY *) MALLOC (sizeof (T_URL_ENTRY) + 2 * len
+				      + MAX_URL_MATCH_COUNT);
+  if (new_entry == NULL)
     {
-      token[i] = NULL;
+      return CCI_ER_NO_MORE_MEMORY;
     }
 
-  error = CCI_ER_NO_ERROR;
-  for (i = 0; match_idx[i] != -1 && match[match_idx[i]].rm_so != -1; i++)
+  new_entry->next = NULL;
+  new_entry->hash = hash;
+  new_entry->is_cached = 0;
+  new_entry->url = new_entry->buf;
+  memcpy (new_entry->url, src, len + 1);
+
+  p = new_entry->url + len + 1;
+  for (i = 0; i < MAX_URL_MATCH_COUNT; i++)
     {
-      const char *t = src + match[match_idx[i]].rm_so;
-      size_t n = match[match_idx[i]].rm_eo - match[match_idx[i]].rm_so;
-      token[i] = MALLOC (n + 1);
-      if (token[i] == NULL)
+      if (length[i] < 0)
 	{
-	  error = CCI_ER_NO_MORE_MEMORY;	/* out of memory */
-	  break;
+	  new_entry->token[i] = NULL;
+	  continue;
 	}
-      strncpy (token[i], t, n);
-      token[i][n] = '\0';
+      new_entry->token[i] = p;
+      memcpy (p, src + offset[i], length[i]);
+      p[length[i]] = '\0';
+      p += length[i] + 1;
     }
 
-  if (error != CCI_ER_NO_ERROR)
+  MUTEX_LOCK (url_cache_mutex);
+  for (e = url_cache[bucket]; e != NULL; e = e->next)
     {
-      /* free allocated memory when error was CCI_ER_NO_MORE_MEMORY */
-      for (i = 0; match_idx[i] != -1 && match[match_idx[i]].rm_so != -1; i++)
+      if (e->hash == hash && strcmp (e->url, src) == 0)
 	{
-	  FREE_MEM (token[i]);
+	  break;
 	}
     }
+  if (e == NULL && url_cache_count < URL_CACHE_MAX_ENTRIES)
+    {
+      new_entry->is_cached = 1;
+      new_entry->next = url_cache[bucket];
+      url_cache[bucket] = new_entry;
+      url_cache_count++;
+    }
+  MUTEX_UNLOCK (url_cache_mutex);
 
-  cub_regfree (&regex);
-  return error;
+  if (e != NULL)
+    {
+      /* another thread added the same url meanwhile */
+      FREE_MEM (new_entry);
+      *entry = e;
+    }
+  else
+    {
+      *entry = new_entry;
+    }
+
+  return CCI_ER_NO_ERROR;
+}
+
+void
+cci_url_release (T_URL_ENTRY * entry)
+{
+  if (entry != NULL && !entry->is_cached)
+    {
+      FREE_MEM (entry);
+    }
 }
 
 long
@@ -65,6 +65,17 @@
  * EXPORTED TYPE DEFINITIONS						*
  ************************************************************************/
 
+typedef struct url_entry T_URL_ENTRY;
+struct url_entry
+{
+  T_URL_ENTRY *next;
+  unsigned int hash;
+  char is_cached;
+  char *url;
+  char *token[MAX_URL_MATCH_COUNT];
+  char buf[1];
+};
+
 
 /************************************************************************
  * EXPORTED FUNCTION PROTOTYPES						*
@@ -92,6 +103,9 @@ extern void ut_bit_to_str (char *bit_str, int bit_size, char *str,
 extern int ut_is_deleted_oid (T_OBJECT * oid);
 
 extern int cci_url_match (const char *src, char *token[]);
+extern void cci_url_cache_init (void);
+extern int cci_url_parse (const char *src, T_URL_ENTRY ** entry);
+extern void cci_url_release (T_URL_ENTRY * entry);
 extern long ut_timeval_diff_msec (struct timeval *start, struct timeval *end);
 
 #ifdef UNICODE_DATA
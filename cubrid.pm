@@ -69,17 +69,80 @@ use strict;
         DBD::cubrid::st->install_method ('cubrid_lob_export');
         DBD::cubrid::st->install_method ('cubrid_lob_import');
         DBD::cubrid::st->install_method ('cubrid_lob_close');
+        DBD::cubrid::st->install_method ('cubrid_fetchall_columnar');
+        DBD::cubrid::db->install_method ('cubrid_bulk_load');
 
         $drh
     }
+
+    sub create_pool {
+
+        my ($class, $dsn, $user, $passwd, $props) = @_;
+        my $drh = DBI->install_driver ('cubrid');
+        my ($url) = DBD::cubrid::dr::_connect_url ($dsn);
+
+        $user = 'public' if not defined $user;
+
+        DBD::cubrid::dr::_pool_new ($drh, $url, $user, $passwd, $props || {})
+            or Carp::croak ("create_pool failed: " . $drh->errstr);
+    }
 }
 
 {   package DBD::cubrid::dr; # ====== DRIVER ======
     use strict;
     
+    my %pools;  # pools created by cubrid_pool => 1, per process
+
     sub connect {
 
         my ($drh, $dsn, $user, $passwd, $attrhash) = @_;
+        my ($connect_dsn, $dbname) = _connect_url ($dsn);
+
+        $user = 'public' if not defined $user;
+
+        if ($attrhash and my $pool = $attrhash->{cubrid_pool}) {
+            if (!ref $pool or ref $pool eq 'HASH') {
+                my %props = ref $pool ? %$pool : ();
+                my $key = join "\0", $$, $connect_dsn, $user,
+                    defined $passwd ? $passwd : '',
+                    map { "$_=$props{$_}" } sort keys %props;
+
+                $pool = $pools{$key} ||=
+                    _pool_new ($drh, $connect_dsn, $user, $passwd, \%props)
+                    or return undef;
+            }
+            elsif ($pool->{pid} != $$) {
+                Carp::croak ("cubrid_pool was created in process $pool->{pid}; " .
+                             "create a pool in each process");
+            }
+            $attrhash = { %$attrhash, cubrid_pool => $pool };
+        }
+
+        my ($dbh) = DBI::_new_dbh ($drh, {
+                'Name' => $dbname,
+                'User' => $user,
+            });
+
+        DBD::cubrid::db::_login($dbh, $connect_dsn, $user, $passwd, $attrhash) or return undef;
+
+        $dbh
+    }
+
+    sub _pool_new {
+
+        my ($drh, $url, $user, $passwd, $props) = @_;
+
+        my $handle = _pool_create ($drh, $url, $user,
+                                   defined $passwd ? $passwd : '', $props)
+            or return undef;
+
+        bless { handle => $handle, pid => $$ }, 'DBD::cubrid::Pool';
+    }
+
+    # Builds the cci:cubrid: url from a DBI:cubrid: DSN
+    sub _connect_url {
+
+        my ($dsn) = @_;
         my %connect_attr;
 
         if ($dsn =~ /=/) {
@@ -103,8 +166,6 @@ use strict;
             Carp::carp("DSN $dsn is not in 'name=value' format");
         }
 
-        $user = 'public' if not defined $user;
-
         my ($host, $port, $dbname);
 
         if ($connect_attr{HOST}) {
@@ -169,14 +230,16 @@ use strict;
             }
         }
 
-        my ($dbh) = DBI::_new_dbh ($drh, {
-                'Name' => $dbname,
-                'User' => $user,
-            });
-
-        DBD::cubrid::db::_login($dbh, $connect_dsn, $user, $passwd, $attrhash) or return undef;
+        if ($connect_attr{DEFER_CLOSE_HANDLES}) {
+            if ($is_connect_attr) {
+                $connect_dsn .= "&deferCloseHandles=$connect_attr{DEFER_CLOSE_HANDLES}";
+            } else {
+                $connect_dsn .= "?deferCloseHandles=$connect_attr{DEFER_CLOSE_HANDLES}";
+                $is_connect_attr = 1;
+            }
+        }
 
-        $dbh
+        return ($connect_dsn, $dbname);
     }
 
 } # end the package of DBD::cubrid::dr
@@ -660,12 +723,193 @@ use strict;
         return $type_info_all;
     }
 
+    sub cubrid_bulk_load {
+        my ($dbh, $table, $columns, $source, %opts) = @_;
+
+        # errors are collected and reported once the transaction is settled
+        local $dbh->{RaiseError} = 0;
+        local $dbh->{PrintError} = 0;
+
+        require Time::HiRes;
+
+        my $chunk_bytes = $opts{chunk_bytes} || 1048576;
+        my $commit_every = defined $opts{commit_every} ? $opts{commit_every} : 1;
+        my $on_chunk = $opts{on_chunk};
+
+        my $next_row = $source;
+        if (ref $source ne 'CODE') {
+            my $separator = defined $opts{separator} ? $opts{separator} : "\t";
+            my $null = defined $opts{null} ? $opts{null} : '\N';
+            $next_row = sub {
+                my $line = <$source>;
+                return undef unless defined $line;
+                chomp $line;
+                return [ map { $_ eq $null ? undef : $_ }
+                         split /\Q$separator\E/, $line, -1 ];
+            };
+        }
+
+        my $sql = "INSERT INTO " . $dbh->quote_identifier ($table) . " (" .
+                  join (', ', map { $dbh->quote_identifier ($_) } @$columns) .
+                  ") VALUES (" . join (', ', ('?') x @$columns) . ")";
+        my $sth = $dbh->prepare ($sql) or return undef;
+        my @types = map { $opts{types} ? $opts{types}[$_] : undef } 0 .. $#$columns;
+
+        # commits follow the chunk cadence, not every request
+        my $auto_commit = $dbh->FETCH ('AutoCommit');
+        $dbh->STORE ('AutoCommit', 0) if $auto_commit;
+
+        my %stats = (rows => 0, errors => 0, chunks => 0, chunk_seconds => []);
+        my $start = Time::HiRes::time ();
+        my $done = 0;
+        my ($err, $errstr);
+
+        while (!$done) {
+            my (@rows, $bytes);
+            $bytes = 0;
+            while ($bytes < $chunk_bytes) {
+                my $row = &$next_row();
+                if (!$row) {
+                    $done = 1;
+                    last;
+                }
+                push @rows, [ @$row ];
+                # each value travels as a 4-byte length, a type byte and its data
+                $bytes += 5 * @$row;
+                $bytes += length for grep { defined } @$row;
+            }
+            last unless @rows;
+
+            my @status;
+            my $chunk_start = Time::HiRes::time ();
+            my $rc = DBD::cubrid::st::_execute_array ($sth, \@rows, \@types,
+                                                      \@status);
+            unless (defined $rc) {
+                ($err, $errstr) = ($sth->err, $sth->errstr);
+                last;
+            }
+            my $seconds = Time::HiRes::time () - $chunk_start;
+
+            my $rejected = grep { ref } @status;
+            $stats{chunks}++;
+            $stats{rows} += @rows - $rejected;
+            $stats{errors} += $rejected;
+            push @{$stats{chunk_seconds}}, $seconds;
+            &$on_chunk($stats{chunks}, scalar @rows, $seconds) if $on_chunk;
+
+            if ($commit_every > 0 && $stats{chunks} % $commit_every == 0
+                    && !$dbh->commit) {
+                ($err, $errstr) = ($dbh->err, $dbh->errstr);
+                last;
+            }
+        }
+
+        if (!defined $err && !$dbh->commit) {
+            ($err, $errstr) = ($dbh->err, $dbh->errstr);
+        }
+        $dbh->rollback if defined $err;
+        $dbh->STORE ('AutoCommit', 1) if $auto_commit;
+        return $dbh->set_err ($err, $errstr) if defined $err;
+
+        $stats{seconds} = Time::HiRes::time () - $start;
+        $stats{rows_per_sec} =
+            $stats{seconds} > 0 ? $stats{rows} / $stats{seconds} : $stats{rows};
+
+        return \%stats;
+    }
+
 }   # end of package DBD::cubrid::db
 
 
+{   package DBD::cubrid::Pool; # ====== CONNECTION POOL ======
+    use strict;
+
+    my $ending = 0;
+    END { $ending = 1 }
+
+    sub stats {
+        my ($pool) = @_;
+        DBD::cubrid::dr::_pool_stats ($pool->{handle});
+    }
+
+    sub DESTROY {
+        my ($pool) = @_;
+
+        # a forked child must not close the connections of its parent, and
+        # at global destruction database handles may still be borrowed
+        return if $ending or $pool->{pid} != $$;
+        DBD::cubrid::dr::_pool_destroy ($pool->{handle});
+    }
+}   # end of package DBD::cubrid::Pool
+
+
 {   package DBD::cubrid::st; # ====== STATEMENT ======
+    use strict;
+    use DBI qw(:sql_types);
 
+    # rows sent to the server in one execute_array request
+    my $array_batch_size = 1000;
+
+    sub execute_for_fetch {
+        my ($sth, $fetch_tuple_sub, $tuple_status) = @_;
+
+        my $num_params = $sth->FETCH('NUM_OF_PARAMS');
+        my $param_types = $sth->FETCH('ParamTypes') || {};
+        my @types = map {
+            my $t = $param_types->{$_};
+            ref $t ? $t->{TYPE} : $t;
+        } 1 .. $num_params;
+
+        # LOB, BIT and collection values need the per-row bind path
+        for my $type (grep { defined } @types) {
+            if ($type == SQL_BLOB || $type == SQL_CLOB ||
+                $type == SQL_BIT || $type == SQL_ARRAY) {
+                return $sth->SUPER::execute_for_fetch ($fetch_tuple_sub,
+                                                       $tuple_status);
+            }
+        }
+
+        ($tuple_status) ? @$tuple_status = () : ($tuple_status = []);
+
+        my $rc_total = 0;
+        while (1) {
+            my @rows;
+            while (@rows < $array_batch_size) {
+                my $tuple = &$fetch_tuple_sub() or last;
+                push @rows, [ @$tuple ];
+            }
+            last unless @rows;
+
+            my $first = @$tuple_status;
+            my $rc = DBD::cubrid::st::_execute_array ($sth, \@rows, \@types,
+                                                      $tuple_status);
+            return undef unless defined $rc;
+
+            # failed rows went through the handle, so they share its state
+            push @$_, $sth->state
+                for grep { ref } @$tuple_status[$first .. $#$tuple_status];
+
+            if ($rc eq '') {
+                # a SELECT: run the rows one at a time
+                my @pending = @rows;
+                return $sth->SUPER::execute_for_fetch (sub {
+                    @pending ? shift @pending : &$fetch_tuple_sub();
+                }, $tuple_status);
+            }
+
+            $rc_total += $rc;
+        }
 
+        my $tuples = @$tuple_status;
+        my $err_count = grep { ref } @$tuple_status;
+        return $sth->set_err ($DBI::stderr,
+                              "executing $tuples generated $err_count errors")
+            if $err_count;
+
+        $tuples ||= "0E0";
+        return $tuples unless wantarray;
+        return ($tuples, $rc_total);
+    }
 }
 
 1;
@@ -781,6 +1025,13 @@ B<query_timeout>: INT. Configures the query timeout of CUBRID.
 B<disconnect_on_query_timeout> : String. Make the query_timeout effective. 
 The value maybe true, on, yes, false, off and no.
 
+B<defer_close_handles> : String. When a statement handle is destroyed, the driver
+does not wait for the server to close the statement: the close is sent along with
+the next prepare. Without this property, statements that returned a result set,
+such as SELECT, are still closed in a round trip of their own. With AutoCommit on,
+a result set that was not fetched to the end is always closed at once, because
+closing it ends the transaction. The value maybe true, on, yes, false, off and no.
+
 The following are some examples about different $dsn:
 
     $db = "testdb";
@@ -798,12 +1049,54 @@ The following are some examples about different $dsn:
 
     $query = 600;
     $dsn = "dbi:cubrid:database=$db;host=$host;port=$port;query_timeout=$query;disconnect_on_query_timeout=yes";
+
+    $dsn = "dbi:cubrid:database=$db;host=$host;port=$port;defer_close_handles=yes";
     
  B<Tips:  the autocommit has been removed from the dsn since RB-8.4.4. If you wanna set up the autocommit of the connection, you have to do:>
 
     $dbh= DBI->connect ($dsn, $user, $password,
                       { RaiseError => 1, PrintError => 1, AutoCommit => 0 });
 
+=head3 B<create_pool>
+
+    use DBD::cubrid;
+
+    $pool = DBD::cubrid->create_pool ($dsn, $user, $password,
+                                      { pool_size => 4, max_wait => 2000 });
+    $dbh = DBI->connect ($dsn, $user, $password, { cubrid_pool => $pool });
+
+Creates a pool of authenticated connections in the current process. A connect
+with the B<cubrid_pool> attribute borrows an idle connection from the pool
+instead of opening a new one, and C<disconnect> rolls back any open transaction
+and gives the connection back. This saves the TCP connect and login round trips
+of each connect, for example in web workers that connect once per request.
+
+The properties are those of the CCI datasource: B<pool_size> (the number of
+connections that can be borrowed at a time, default 10), B<max_pool_size> (the
+largest value B<pool_size> can be changed to), B<max_wait> (msec a connect waits
+for a connection when all of them are borrowed, default 1000),
+B<idle_timeout> (msec after which an unused connection is closed, default 0 for
+never), B<default_autocommit>, B<default_isolation>, B<default_lock_timeout>,
+B<login_timeout> and B<query_timeout>. Only the first connection is opened by
+C<create_pool>, which croaks if it fails; the rest are opened in the background
+and as they are needed.
+
+Instead of a pool object, C<cubrid_pool> can be C<1> or a hash reference of
+properties. The driver then keeps one pool per process for each DSN, user,
+password and set of properties:
+
+    $dbh = DBI->connect ($dsn, $user, $password, { cubrid_pool => { pool_size => 2 } });
+
+Connections cannot be shared between processes, so a pool is only usable in the
+process that created it. Forking servers should create the pool in each child,
+which the implicit C<cubrid_pool> form does by itself, and set
+L<DBI/AutoInactiveDestroy> on handles that live across a fork.
+
+C<< $pool->stats >> returns a hash reference with the number of C<borrows>,
+C<waits> (connects that had to wait), C<timeouts>, the connects C<waiting> right
+now, the connections C<open> and C<wait_histogram>, where element 0 counts waits
+shorter than 1 msec and element I<i> waits of 2^(I<i>-1) to 2^I<i> - 1 msec.
+
 =head1 DBI Database Handle Object
 
 =head2 Database Handle Methods
@@ -1061,6 +1354,34 @@ save and exit. Then you can execute
 
 After doing these, you can use the private database handle methods.
 
+=head3 B<cubrid_bulk_load>
+
+    $stats = $dbh->cubrid_bulk_load ($table, \@columns, $source, %options);
+
+Inserts rows into C<$table> in chunks, each chunk sent to the server in a single
+request. C<$source> is either a code reference returning the next row as an array
+reference (undef at the end), or a filehandle read line by line, with the fields
+separated by a tab. The options are
+
+    chunk_bytes   => 1048576,  # approximate size of the rows sent per request
+    commit_every  => 1,        # commit after this many chunks; 0 commits at the end
+    types         => [ SQL_INTEGER, undef ],  # bind type of each column
+    separator     => "\t",     # field separator of filehandle input
+    null          => '\N',     # field value read from a filehandle as NULL
+    on_chunk      => sub { my ($chunk, $rows, $seconds) = @_; ... },
+
+AutoCommit is turned off during the load and restored afterwards. The method returns a
+hash reference with C<rows> (rows inserted), C<errors> (rows rejected by the server),
+C<chunks>, C<seconds>, C<rows_per_sec> and C<chunk_seconds>, the time each chunk took.
+The table and column names are quoted, so reserved words and mixed case work. If a
+chunk cannot be executed or a commit fails, the rows since the last commit are rolled
+back and undef is returned. For example
+
+    open my $fh, '<', 'users.tsv' or die $!;
+    my $stats = $dbh->cubrid_bulk_load ('users', [qw(id name email)], $fh,
+                                        commit_every => 10);
+    printf "%d rows, %.0f rows/s\n", $stats->{rows}, $stats->{rows_per_sec};
+
 =head3 B<cubrid_lob_get>
 
     $sth->cubrid_lob_get ($column);
@@ -1103,6 +1424,31 @@ For example
 This method will close the lob object that B<cubrid_lob_get> gets. Once you use B<cubrid_lob_get>,
 you'd better use this method when you don't use the lob object any more.
 
+=head3 B<cubrid_fetchall_columnar>
+
+    $cols = $sth->cubrid_fetchall_columnar ();
+    $cols = $sth->cubrid_fetchall_columnar ($max_rows);
+
+Fetches all the remaining rows (or at most C<$max_rows> rows) of an executed SELECT
+and returns them column by column: a reference to an array holding one array
+reference per column, in select list order. The rows are copied straight from the
+driver's fetch buffer in a single loop, which is much cheaper than calling
+L</fetchrow_arrayref> for every row when the result set is large. For example
+
+    $sth = $dbh->prepare ("SELECT id, name FROM test");
+    $sth->execute;
+
+    my $cols = $sth->cubrid_fetchall_columnar ();
+    my ($ids, $names) = @$cols;
+
+    while (my $chunk = $sth->cubrid_fetchall_columnar (10000)) {
+        last unless @{$chunk->[0]};
+        ...
+    }
+
+If an error occurs, the data read in so far is returned; check C<$sth->err>
+afterwards unless C<RaiseError> is enabled.
+
 =head2 Database Handle Attributes
 
 =head3 B<AutoCommit> (boolean)
@@ -1115,6 +1461,51 @@ explicitly set it when calling L</connect>.
 
 Returns the name of the current database.
 
+=head3 B<cubrid_pool> (pool object, read-only)
+
+The pool the connection was borrowed from, see L</create_pool>. It can only be
+given to C<connect>.
+
+=head3 B<cubrid_read_ahead> (boolean)
+
+When enabled, the driver asks the server for the next block of rows as soon as
+it starts on the current one, so the network round trip overlaps with the
+processing of the rows already fetched. This applies to SELECT statements run
+with AutoCommit on, whose cursors are forward-only. Statement handles prepared
+afterwards inherit the value; it can also be passed to L</prepare>:
+
+    $sth = $dbh->prepare ("SELECT * FROM big_table", { cubrid_read_ahead => 1 });
+
+=head3 B<cubrid_stmt_pool_size> (integer)
+
+The number of closed statements whose server side handles are kept open, keyed
+by SQL text. Preparing the same SQL again, for example in the next web request,
+reuses the server handle without a prepare round trip to the server. When the
+pool is full, the least recently used statement is closed. The default of 0
+turns the pool off.
+
+    $dbh = DBI->connect ($dsn, $user, $pass, { cubrid_stmt_pool_size => 300 });
+
+The pool works together with L<DBI/prepare_cached>: statement handles kept by
+C<prepare_cached> stay checked out, while statements prepared with L</prepare>
+go back to the pool when the handle is destroyed.
+
+=head3 B<RowCacheSize> (integer)
+
+Controls how many rows are transferred from the server in one round trip when
+fetching the result of a SELECT. Statement handles prepared afterwards inherit
+the value, and it can also be passed to L</prepare> as an attribute or set on a
+statement handle directly.
+
+    $dbh->{RowCacheSize} = 1000;    # fetch 1000 rows per round trip
+    $dbh->{RowCacheSize} = 0;       # size each fetch automatically
+    $dbh->{RowCacheSize} = -4194304; # size each fetch automatically, within 4MB
+
+A positive value is a number of rows. With 0 the driver grows the number of rows
+per round trip from the observed row width, keeping one fetch within 1MB; a
+negative value does the same with the absolute value as the byte budget. If the
+attribute is not set, 100 rows are fetched per round trip.
+
 =head1 DBI STATEMENT HANDLE OBJECTS
 
 =head2 Statement Handle Methods
@@ -1157,6 +1548,12 @@ must be included in the bind_param function.
 Note that, DBD:cubrid does not support BIT, SET, MULTISET and SEQUENCE now. And if you want to
 bind BLOB/CLOB data, you must specify C<$bind_type>.
 
+Numbers are sent to the server as numbers, without a string conversion, when C<$bind_type> is
+an integer type (SQL_INTEGER, SQL_SMALLINT, SQL_TINYINT, SQL_BIGINT) and the value is a Perl
+integer, or a floating point type (SQL_REAL, SQL_FLOAT, SQL_DOUBLE) and the value is a Perl
+number. Without C<$bind_type>, integers that were never used as strings are sent as numbers too;
+everything else is sent as a string and converted by the server.
+
 Examples of use:
 
     # CREATE TABLE test_cubrid (id INT, name varchar(50), birthday DATE, salary FLOAT)
@@ -1217,6 +1614,12 @@ previously bound via the "bind_param_array" method. See the DBI documentation fo
     $sth->execute_array(\%attr)
     $sth->execute_array(\%attr, @bind_values)
    
+DBD::cubrid sends the rows to the server in batches of 1000, each batch in a single
+request, instead of executing the statement once per row. C<ArrayTupleStatus> receives
+the affected row count or the error of every row as usual. Statements with BLOB, CLOB,
+BIT or collection parameters, and SELECT statements, are executed one row at a time.
+The same applies to L<DBI/execute_for_fetch>.
+
 Examples of use:
     
     use strict;
@@ -1386,6 +1789,11 @@ Returns an arrayref of integer values for each column returned by the statement.
 The number indicates if the column is nullable or not. 0 = not nullable, 1 = nullable.
 This method returns undef if called before C<execute()>.
 
+=head3 B<RowCacheSize> (integer)
+
+The number of rows fetched per round trip for this statement. See the database
+handle attribute L</RowCacheSize> for the meaning of the values.
+
 =head1 INSTALLATION
 
 =head2 Environment Variables
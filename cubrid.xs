@@ -6,7 +6,27 @@ INCLUDE: cubrid.xsi
 
 MODULE = DBD::cubrid	PACKAGE = DBD::cubrid::dr
 
+void
+_pool_create( drh, url, user, password, props )
+    SV *drh
+    char *url
+    char *user
+    char *password
+    HV *props
+    CODE:
+    ST(0) = cubrid_pool_create (drh, url, user, password, props);
+
+void
+_pool_destroy( handle )
+    IV handle
+    CODE:
+    cubrid_pool_destroy (handle);
 
+void
+_pool_stats( handle )
+    IV handle
+    CODE:
+    ST(0) = cubrid_pool_stats (handle);
 
 
 MODULE = DBD::cubrid	PACKAGE = DBD::cubrid::db
@@ -126,3 +146,19 @@ cubrid_lob_close( sth )
     CODE:
     ST(0) = sv_2mortal (newSViv (cubrid_st_lob_close(sth)));
 
+
+void
+cubrid_fetchall_columnar( sth, max_rows = 0 )
+    SV *sth
+    int max_rows
+    CODE:
+    ST(0) = cubrid_st_fetchall_columnar(sth, max_rows);
+
+void
+_execute_array( sth, rows, types, tuple_status )
+    SV *sth
+    AV *rows
+    AV *types
+    AV *tuple_status
+    CODE:
+    ST(0) = cubrid_st_execute_array(sth, rows, types, tuple_status);
@@ -45,6 +45,9 @@
 #define CUBRID_ER_MSG_LEN 1024
 #define CUBRID_BUFFER_LEN 4096
 
+/* byte budget of one fetch when RowCacheSize is 0 (automatic) */
+#define CUBRID_DEFAULT_FETCH_BUDGET (1024 * 1024)
+
 static struct _error_message {
     int err_code;
     char *err_msg;
@@ -65,17 +68,25 @@ typedef int (*CCI_GET_LAST_INSERT_ID) (int con, void *buff,
                                        T_CCI_ERROR * err_buf);
 static CCI_GET_LAST_INSERT_ID cci_get_last_insert_id_fp = NULL;
 
+/* where cubrid_st_fetchall_columnar puts the values cci_fetch_rows reads */
+typedef struct {
+    AV **col_avs;
+    T_CUBRID_DECODER *decoder;
+} T_CUBRID_COLUMNS;
+
 
 /***************************************************************************
  * Private function prototypes
  **************************************************************************/
 
 static int _dbd_db_end_tran (SV *dbh, imp_dbh_t *imp_dbh, int type);
+static int _dbd_db_login_pool (SV *dbh, imp_dbh_t *imp_dbh, SV *pool);
 
 static int _cubrid_lob_bind (SV *sv,
                              int index,
                              IV sql_type,
                              char *buf,
+                             STRLEN len,
                              T_CCI_ERROR *error);
 static int _cubrid_lob_new (int conn, 
                             T_CCI_LOB *lob, 
@@ -106,8 +117,33 @@ static int _cubrid_fetch_schema (AV *rows_av,
 static int _cubrid_fetch_row (AV *av, 
                               int req_handle, 
                               int col_count, 
-                              T_CCI_COL_INFO *col_info, 
+                              T_CUBRID_DECODER *decoder, 
                               T_CCI_ERROR *error);
+static int _cubrid_fetch_value (SV *sv, 
+                                int req_handle, 
+                                int col, 
+                                T_CUBRID_DECODER decoder, 
+                                T_CCI_ERROR *error);
+static int _cubrid_decoder_a_type (T_CUBRID_DECODER decoder);
+static void _cubrid_set_value (SV *sv, 
+                               T_CUBRID_DECODER decoder, 
+                               void *value, 
+                               int ind);
+static void _cubrid_push_column_value (void *arg, 
+                                       int col, 
+                                       void *value, 
+                                       int ind);
+static T_CUBRID_DECODER *_cubrid_build_decoder (T_CCI_COL_INFO *col_info,
+                                                int col_count);
+static void _cubrid_set_date (SV *sv, 
+                              T_CCI_DATE *date, 
+                              T_CUBRID_DECODER decoder);
+static int _cubrid_set_row_cache_size (int req_handle, int size);
+static void _cubrid_unbind_array (imp_sth_t *imp_sth);
+static int _cubrid_bind_number (imp_sth_t *imp_sth, int index,
+                                SV *value, IV sql_type, int *res);
+static char *_cubrid_hold_bind_value (imp_sth_t *imp_sth, int index,
+                                      SV *value, STRLEN *len);
 
 /***************************************************************************
  * 
@@ -271,6 +307,14 @@ dbd_db_login6( SV *dbh, imp_dbh_t *imp_dbh,
 {
     int  con, res;
     T_CCI_ERROR error;
+    SV **svp;
+
+    if (attr && SvROK (attr) && SvTYPE (SvRV (attr)) == SVt_PVHV
+        && (svp = hv_fetch ((HV *) SvRV (attr), "cubrid_pool", 11, 0)) != NULL
+        && sv_isobject (*svp) && sv_derived_from (*svp, "DBD::cubrid::Pool"))
+      {
+        return _dbd_db_login_pool (dbh, imp_dbh, *svp);
+      }
 
     if ((con = cci_connect_with_url_ex (dbname, uid, pwd, &error)) < 0)
       {
@@ -292,6 +336,56 @@ dbd_db_login6( SV *dbh, imp_dbh_t *imp_dbh,
     return TRUE;  
 }
 
+/***************************************************************************
+ *
+ * Name:    _dbd_db_login_pool
+ *
+ * Purpose: Log in by borrowing an authenticated connection from a pool
+ *          created with DBD::cubrid->create_pool
+ *
+ * Input:   dbh - database handle being initialized
+ *          imp_dbh - drivers private database handle data
+ *          pool - the DBD::cubrid::Pool object
+ *
+ * Returns: TRUE for success, FALSE otherwise
+ *
+ **************************************************************************/
+
+static int
+_dbd_db_login_pool( SV *dbh, imp_dbh_t *imp_dbh, SV *pool )
+{
+    int con;
+    T_CCI_ERROR error;
+    T_CCI_DATASOURCE *ds;
+    SV **svp;
+
+    svp = hv_fetch ((HV *) SvRV (pool), "handle", 6, 0);
+    if (svp == NULL || !SvOK (*svp)) {
+        handle_error (dbh, CCI_ER_INVALID_DATASOURCE, NULL);
+        return FALSE;
+    }
+    ds = INT2PTR (T_CCI_DATASOURCE *, SvIV (*svp));
+
+    if ((con = cci_datasource_borrow (ds, &error)) < 0) {
+        handle_error (dbh, con, &error);
+        return FALSE;
+    }
+
+    /* 
+     * the connection was rolled back when it was released, so there is
+     * no transaction to end here; the reference keeps the pool alive
+     * until the connection is given back
+     */
+    imp_dbh->handle = con;
+    imp_dbh->pool = ds;
+    imp_dbh->pool_sv = newSVsv (pool);
+
+    DBIc_IMPSET_on(imp_dbh);
+    DBIc_ACTIVE_on(imp_dbh);
+
+    return TRUE;
+}
+
 /***************************************************************************
  *
  * Name:    dbd_db_commit
@@ -351,6 +445,13 @@ dbd_db_destroy( SV *dbh, imp_dbh_t *imp_dbh )
         (void)dbd_db_disconnect(dbh, imp_dbh);
     }
 
+    if (imp_dbh->pool_sv) {
+        /* InactiveDestroy: leave the connection borrowed */
+        SvREFCNT_dec (imp_dbh->pool_sv);
+        imp_dbh->pool_sv = Nullsv;
+        imp_dbh->pool = NULL;
+    }
+
     DBIc_IMPSET_off(imp_dbh);
 }
 
@@ -375,6 +476,20 @@ dbd_db_disconnect( SV *dbh, imp_dbh_t *imp_dbh )
 
     DBIc_ACTIVE_off(imp_dbh);
 
+    if (imp_dbh->pool) {
+        cci_datasource_release (imp_dbh->pool, imp_dbh->handle, &error);
+
+        imp_dbh->pool = NULL;
+        SvREFCNT_dec (imp_dbh->pool_sv);
+        imp_dbh->pool_sv = Nullsv;
+
+        if (error.err_code < 0) {
+            handle_error (dbh, error.err_code, &error);
+            return FALSE;
+        }
+        return TRUE;
+    }
+
     if ((res = cci_disconnect (imp_dbh->handle, &error)) < 0) {
         handle_error (dbh, res, &error);
         return FALSE;
@@ -421,6 +536,39 @@ dbd_db_STORE_attrib( SV *dbh, imp_dbh_t *imp_dbh, SV *keysv, SV *valuesv )
             DBIc_set (imp_dbh, DBIcf_AutoCommit, on);
             return TRUE;
         }
+        break;
+    case 11:
+        if (strEQ("cubrid_pool", key)) {
+            /* only takes effect at connect time */
+            return TRUE;
+        }
+        break;
+    case 12:
+        if (strEQ("RowCacheSize", key)) {
+            imp_dbh->has_row_cache_size = SvOK (valuesv);
+            imp_dbh->row_cache_size = 
+                imp_dbh->has_row_cache_size ? SvIV (valuesv) : 0;
+            return TRUE;
+        }
+        break;
+    case 17:
+        if (strEQ("cubrid_read_ahead", key)) {
+            imp_dbh->read_ahead = on;
+            return TRUE;
+        }
+        break;
+    case 21:
+        if (strEQ("cubrid_stmt_pool_size", key)) {
+            int res, size = SvOK (valuesv) ? SvIV (valuesv) : 0;
+
+            if ((res = cci_set_statement_pool_size (imp_dbh->handle, size)) < 0) {
+                handle_error (dbh, res, NULL);
+                return TRUE;
+            }
+            imp_dbh->stmt_pool_size = size;
+            return TRUE;
+        }
+        break;
     }
     return FALSE;
 }
@@ -453,10 +601,145 @@ dbd_db_FETCH_attrib(SV *dbh, imp_dbh_t *imp_dbh, SV *keysv)
             retsv = boolSV(DBIc_has(imp_dbh,DBIcf_AutoCommit));
         }
         break;
+    case 11:
+        if (strEQ("cubrid_pool", key) && imp_dbh->pool_sv) {
+            retsv = newSVsv (imp_dbh->pool_sv);
+        }
+        break;
+    case 12:
+        if (strEQ("RowCacheSize", key) && imp_dbh->has_row_cache_size) {
+            retsv = newSViv (imp_dbh->row_cache_size);
+        }
+        break;
+    case 17:
+        if (strEQ("cubrid_read_ahead", key)) {
+            retsv = boolSV (imp_dbh->read_ahead);
+        }
+        break;
+    case 21:
+        if (strEQ("cubrid_stmt_pool_size", key)) {
+            retsv = newSViv (imp_dbh->stmt_pool_size);
+        }
+        break;
     }
     return sv_2mortal(retsv);
 }
 
+/***************************************************************************
+ *
+ * Name:    cubrid_pool_create
+ *
+ * Purpose: Create a CCI datasource that pooled connects borrow their
+ *          connections from
+ *
+ * Input:   drh - driver handle, used for error reporting
+ *          url - the cci:cubrid: url built from the DSN
+ *          uid - user name to connect as
+ *          pwd - password to connect with
+ *          props - datasource properties, e.g. pool_size or max_wait
+ *
+ * Returns: the address of the datasource, undef on error
+ *
+ **************************************************************************/
+
+SV *
+cubrid_pool_create( SV *drh, char *url, char *uid, char *pwd, HV *props )
+{
+    T_CCI_PROPERTIES *prop;
+    T_CCI_DATASOURCE *ds;
+    T_CCI_ERROR error;
+    HE *he;
+
+    if ((prop = cci_property_create ()) == NULL) {
+        handle_error (drh, CCI_ER_NO_MORE_MEMORY, NULL);
+        return &PL_sv_undef;
+    }
+
+    hv_iterinit (props);
+    while ((he = hv_iternext (props)) != NULL) {
+        I32 kl;
+        char *key = hv_iterkey (he, &kl);
+        SV *valuesv = hv_iterval (props, he);
+
+        if (SvOK (valuesv)) {
+            cci_property_set (prop, key, SvPV_nolen (valuesv));
+        }
+    }
+    cci_property_set (prop, (char *) CCI_DS_PROPERTY_URL, url);
+    cci_property_set (prop, (char *) CCI_DS_PROPERTY_USER, uid);
+    cci_property_set (prop, (char *) CCI_DS_PROPERTY_PASSWORD, pwd);
+
+    ds = cci_datasource_create (prop, &error);
+    cci_property_destroy (prop);
+
+    if (ds == NULL) {
+        handle_error (drh, error.err_code < 0 ?
+                      error.err_code : CCI_ER_INVALID_DATASOURCE, &error);
+        return &PL_sv_undef;
+    }
+
+    return sv_2mortal (newSViv (PTR2IV (ds)));
+}
+
+/***************************************************************************
+ *
+ * Name:    cubrid_pool_destroy
+ *
+ * Purpose: Close the connections of a pool and free it
+ *
+ * Input:   handle - the address returned by cubrid_pool_create
+ *
+ * Returns: Nothing
+ *
+ **************************************************************************/
+
+void
+cubrid_pool_destroy( IV handle )
+{
+    cci_datasource_destroy (INT2PTR (T_CCI_DATASOURCE *, handle));
+}
+
+/***************************************************************************
+ *
+ * Name:    cubrid_pool_stats
+ *
+ * Purpose: Report the borrow counters of a pool
+ *
+ * Input:   handle - the address returned by cubrid_pool_create
+ *
+ * Returns: reference to a hash of the counters, undef on error
+ *
+ **************************************************************************/
+
+SV *
+cubrid_pool_stats( IV handle )
+{
+    int i;
+    T_CCI_DATASOURCE_STATS stats;
+    HV *hv;
+    AV *histogram;
+
+    if (cci_datasource_get_stats (INT2PTR (T_CCI_DATASOURCE *, handle),
+                                  &stats) < 0) {
+        return &PL_sv_undef;
+    }
+
+    histogram = newAV ();
+    for (i = 0; i < CCI_DS_WAIT_HISTOGRAM_SIZE; i++) {
+        av_push (histogram, newSVuv (stats.wait_histogram[i]));
+    }
+
+    hv = newHV ();
+    (void) hv_store (hv, "borrows", 7, newSVuv (stats.num_borrow), 0);
+    (void) hv_store (hv, "waits", 5, newSVuv (stats.num_wait), 0);
+    (void) hv_store (hv, "timeouts", 8, newSVuv (stats.num_timeout), 0);
+    (void) hv_store (hv, "waiting", 7, newSViv (stats.num_waiting), 0);
+    (void) hv_store (hv, "open", 4, newSViv (stats.num_open), 0);
+    (void) hv_store (hv, "wait_histogram", 14, newRV_noinc ((SV *) histogram), 0);
+
+    return sv_2mortal (newRV_noinc ((SV *) hv));
+}
+
 /**************************************************************************
  *
  * Name:    dbd_db_last_insert_id
@@ -595,6 +878,7 @@ dbd_st_prepare( SV *sth, imp_sth_t *imp_sth, char *statement, SV *attribs )
 {
     int res;
     T_CCI_ERROR error;
+    SV **svp;
 
     D_imp_dbh_from_sth;
 
@@ -607,6 +891,8 @@ dbd_st_prepare( SV *sth, imp_sth_t *imp_sth, char *statement, SV *attribs )
     imp_sth->sql_type = 0;
     imp_sth->affected_rows = -1;
     imp_sth->lob = NULL;
+    imp_sth->decoder = NULL;
+    imp_sth->bind_values = NULL;
 
     if ((res = cci_prepare (imp_sth->conn, statement, 0, &error)) < 0) {
         handle_error (sth, res, &error);
@@ -615,6 +901,22 @@ dbd_st_prepare( SV *sth, imp_sth_t *imp_sth, char *statement, SV *attribs )
 
     imp_sth->handle = res;
 
+    imp_sth->has_row_cache_size = imp_dbh->has_row_cache_size;
+    imp_sth->row_cache_size = imp_dbh->row_cache_size;
+    if ((svp = DBD_ATTRIB_GET_SVP (attribs, "RowCacheSize", 12)) && SvOK (*svp)) {
+        imp_sth->has_row_cache_size = 1;
+        imp_sth->row_cache_size = SvIV (*svp);
+    }
+
+    if (imp_sth->has_row_cache_size) {
+        _cubrid_set_row_cache_size (res, imp_sth->row_cache_size);
+    }
+
+    if ((svp = DBD_ATTRIB_GET_SVP (attribs, "cubrid_read_ahead", 17))
+            ? SvTRUE (*svp) : imp_dbh->read_ahead) {
+        cci_fetch_read_ahead (res, 1);
+    }
+
     DBIc_NUM_PARAMS(imp_sth) = cci_get_bind_num (res);
 
     DBIc_IMPSET_on(imp_sth);
@@ -661,6 +963,14 @@ dbd_st_execute( SV *sth, imp_sth_t *imp_sth )
     imp_sth->sql_type = sql_type;
     imp_sth->col_count = col_count;
 
+    if (imp_sth->decoder) {
+        Safefree (imp_sth->decoder);
+        imp_sth->decoder = NULL;
+    }
+    if (col_info && col_count > 0) {
+        imp_sth->decoder = _cubrid_build_decoder (col_info, col_count);
+    }
+
     switch (sql_type) {
     case SQLX_CMD_INSERT:
     case SQLX_CMD_UPDATE:
@@ -729,7 +1039,7 @@ dbd_st_fetch( SV *sth, imp_sth_t *imp_sth )
     if ((res = _cubrid_fetch_row (av, 
                                   imp_sth->handle, 
                                   imp_sth->col_count, 
-                                  imp_sth->col_info, 
+                                  imp_sth->decoder, 
                                   &error)) < 0) {
         goto ERR_ST_FETCH;
     }
@@ -745,6 +1055,78 @@ ERR_ST_FETCH:
     return Nullav;	  
 }
 
+/***************************************************************************
+ *
+ * Name:    cubrid_st_fetchall_columnar
+ *
+ * Purpose: Fetch the remaining rows of a SELECT into one Perl array per
+ *          column. cci_fetch_rows walks the tuples CCI holds in its fetch
+ *          buffer, so there is no per-row DBI dispatch, row buffer copy
+ *          or statement lookup.
+ *
+ * Input:   sth - statement handle
+ *          max_rows - stop after this many rows, or <= 0 for all rows
+ *
+ * Returns: reference to an array of column array references, or
+ *          undef when the statement is not an executed SELECT. If an
+ *          error occurs, the data read in so far is returned.
+ *
+ **************************************************************************/
+
+SV *
+cubrid_st_fetchall_columnar( SV *sth, int max_rows )
+{
+    int i, res;
+    int *a_types;
+    T_CCI_ERROR error;
+    T_CUBRID_COLUMNS columns;
+    AV *cols_av, **col_avs;
+
+    D_imp_sth (sth);
+
+    if (imp_sth->sql_type != SQLX_CMD_SELECT || !imp_sth->decoder) {
+        handle_error (sth, CUBRID_ER_CANNOT_FETCH_DATA, NULL);
+        return &PL_sv_undef;
+    }
+
+    cols_av = newAV ();
+    av_extend (cols_av, imp_sth->col_count - 1);
+    Newx (col_avs, imp_sth->col_count, AV *);
+    Newx (a_types, imp_sth->col_count, int);
+
+    for (i = 0; i < imp_sth->col_count; i++) {
+        col_avs[i] = newAV ();
+        if (imp_sth->affected_rows > 0) {
+            av_extend (col_avs[i], (max_rows > 0 && max_rows < imp_sth->affected_rows ?
+                                    max_rows : imp_sth->affected_rows) - 1);
+        }
+        av_store (cols_av, i, newRV_noinc ((SV *) col_avs[i]));
+        a_types[i] = _cubrid_decoder_a_type (imp_sth->decoder[i]);
+    }
+
+    columns.col_avs = col_avs;
+    columns.decoder = imp_sth->decoder;
+
+    res = cci_fetch_rows (imp_sth->handle, 
+                          max_rows, 
+                          imp_sth->col_count, 
+                          a_types, 
+                          _cubrid_push_column_value, 
+                          &columns, 
+                          &error);
+    Safefree (a_types);
+    Safefree (col_avs);
+
+    if (res < 0) {
+        DBIc_ACTIVE_off (imp_sth);
+        handle_error (sth, res, &error);
+    } else if (max_rows <= 0 || res < max_rows) {
+        DBIc_ACTIVE_off (imp_sth);
+    }
+
+    return sv_2mortal (newRV_noinc ((SV *) cols_av));
+}
+
 /***************************************************************************
  *
  * Name:    dbd_st_finish
@@ -796,9 +1178,19 @@ dbd_st_destroy( SV *sth, imp_sth_t *imp_sth )
             imp_sth->lob = NULL;
         }
 
+        if (imp_sth->decoder) {
+            Safefree (imp_sth->decoder);
+            imp_sth->decoder = NULL;
+        }
+
         cci_close_req_handle (imp_sth->handle);
         imp_sth->handle = 0;
 
+        if (imp_sth->bind_values) {
+            SvREFCNT_dec (imp_sth->bind_values);
+            imp_sth->bind_values = NULL;
+        }
+
         imp_sth->col_count = -1;
         imp_sth->sql_type = 0;
         imp_sth->affected_rows = -1;
@@ -827,6 +1219,29 @@ dbd_st_destroy( SV *sth, imp_sth_t *imp_sth )
 int
 dbd_st_STORE_attrib( SV *sth, imp_sth_t *imp_sth, SV *keysv, SV *valuesv )
 {
+    STRLEN kl;
+    char *key = SvPV (keysv, kl);
+    int res;
+
+    switch (kl) {
+    case 12:
+        if (strEQ ("RowCacheSize", key)) {
+            if (!SvOK (valuesv)) {
+                break;
+            }
+
+            if ((res = _cubrid_set_row_cache_size (imp_sth->handle, 
+                                                   SvIV (valuesv))) < 0) {
+                handle_error (sth, res, NULL);
+                return FALSE;
+            }
+
+            imp_sth->has_row_cache_size = 1;
+            imp_sth->row_cache_size = SvIV (valuesv);
+        }
+        break;
+    }
+
     return TRUE;
 }
 
@@ -907,6 +1322,11 @@ dbd_st_FETCH_attrib( SV *sth, imp_sth_t *imp_sth, SV *keysv )
             }
         }
         break;
+    case 12:
+        if (strEQ ("RowCacheSize", key) && imp_sth->has_row_cache_size) {
+            retsv = newSViv (imp_sth->row_cache_size);
+        }
+        break;
     }
 
     return sv_2mortal (retsv);
@@ -1080,7 +1500,7 @@ dbd_bind_ph( SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
     int res = 0,i=0,num=0,buffer_is_null;
     int* indicator= NULL;   
     char *bind_value = NULL,*temp=NULL;
-    STRLEN bind_value_len;
+    STRLEN bind_value_len = 0;
     T_CCI_ERROR error;
     AV* aTemp=NULL;
     SV** element=NULL;
@@ -1095,7 +1515,7 @@ dbd_bind_ph( SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
         return FALSE;
     }  
     
-    buffer_is_null = !(SvOK(newSVsv(value)) && newSVsv(value));
+    buffer_is_null = !SvOK(value);
     if(!buffer_is_null)
    {
        if(SvROK(value) && SvTYPE(SvRV(value))==SVt_PVAV)
@@ -1153,10 +1573,6 @@ dbd_bind_ph( SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
                 return FALSE;    
             } 
        }
-       else
-       {
-           bind_value = SvPV (value, bind_value_len);
-       }
    }
 
     if (SvOK(value) &&
@@ -1177,10 +1593,14 @@ dbd_bind_ph( SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
     switch(sql_type) {
     case SQL_BLOB:
     case SQL_CLOB:
+        if (!buffer_is_null) {
+            bind_value = SvPV (value, bind_value_len);
+        }
         if ((res = _cubrid_lob_bind (sth, 
                                      index, 
                                      sql_type, 
                                      bind_value, 
+                                     bind_value_len,
                                      &error)) < 0) {
             handle_error (sth, res, &error);
             return FALSE;
@@ -1222,9 +1642,23 @@ dbd_bind_ph( SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
             res = cci_bind_param (imp_sth->handle, index, CCI_A_TYPE_SET, set, CCI_U_TYPE_SET, 0);            
             cci_set_free (set);        
         }
-        else
+        else if (! _cubrid_bind_number (imp_sth, index, value, sql_type, &res))
         {
-            res = cci_bind_param (imp_sth->handle, index, CCI_A_TYPE_STR, bind_value, u_type, 0);
+            D_imp_dbh_from_sth;
+
+            if (imp_dbh->stmt_pool_size > 0) {
+                /* a pooled handle outlives imp_sth->bind_values, so CCI
+                 * keeps its own copy */
+                bind_value = SvPV (value, bind_value_len);
+                res = cci_bind_param_ex (imp_sth->handle, index, CCI_A_TYPE_STR,
+                                         bind_value, (int) bind_value_len,
+                                         u_type, 0);
+            } else {
+                bind_value = _cubrid_hold_bind_value (imp_sth, index, value, &bind_value_len);
+                res = cci_bind_param_ex (imp_sth->handle, index, CCI_A_TYPE_STR,
+                                         bind_value, (int) bind_value_len,
+                                         u_type, CCI_BIND_PTR);
+            }
         }
     } 
     else 
@@ -1241,6 +1675,282 @@ dbd_bind_ph( SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
 }
 
 
+/***************************************************************************
+ *
+ * Name:    cubrid_st_execute_array
+ *
+ * Purpose: Execute a prepared statement once for every row in rows,
+ *          shipping all of them to the server in one CAS_FC_EXECUTE_ARRAY
+ *          request. The rows are bound column-wise through
+ *          cci_bind_param_array; the outcome of each row is pushed onto
+ *          tuple_status, either the affected row count or an
+ *          [ err, errstr ] array reference. A failed row is also reported
+ *          through handle_error, so the handle holds the last of them.
+ *
+ * Input:   sth - statement handle
+ *          rows - array of row array references, one value per placeholder
+ *          types - SQL type of each placeholder, undef for the default
+ *          tuple_status - array receiving the status of each row
+ *
+ * Returns: the total number of affected rows, undef if the request as a
+ *          whole failed, or an empty string for a SELECT statement, which
+ *          must be run through the row-at-a-time execute instead.
+ *
+ **************************************************************************/
+
+SV *
+cubrid_st_execute_array( SV *sth, AV *rows, AV *types, AV *tuple_status )
+{
+    int i, j, res, num_rows, num_params, col_count;
+    IV rc_total = 0;
+    char **values = NULL;
+    int *null_ind = NULL;
+    T_CCI_QUERY_RESULT *qr = NULL;
+    T_CCI_SQLX_CMD sql_type;
+    T_CCI_U_TYPE u_type;
+    T_CCI_ERROR error = { 0, "" };
+    T_CCI_ERROR row_error;
+    SV **svp;
+    AV *row, *err_av;
+
+    D_imp_sth (sth);
+
+    cci_get_result_info (imp_sth->handle, &sql_type, &col_count);
+    if (sql_type == SQLX_CMD_SELECT) {
+        return &PL_sv_no;
+    }
+
+    num_rows = av_len (rows) + 1;
+    num_params = DBIc_NUM_PARAMS (imp_sth);
+    if (num_rows == 0) {
+        return sv_2mortal (newSViv (0));
+    }
+
+    Newx (values, num_rows * num_params, char *);
+    Newx (null_ind, num_rows * num_params, int);
+
+    for (i = 0; i < num_rows; i++) {
+        svp = av_fetch (rows, i, 0);
+        if (!svp || !SvROK (*svp) || SvTYPE (SvRV (*svp)) != SVt_PVAV ||
+                av_len ((AV *) SvRV (*svp)) + 1 != num_params) {
+            Safefree (values);
+            Safefree (null_ind);
+            handle_error (sth, CCI_ER_BIND_INDEX, NULL);
+            return &PL_sv_undef;
+        }
+        row = (AV *) SvRV (*svp);
+
+        /* column j of all rows is contiguous, as cci_bind_param_array wants */
+        for (j = 0; j < num_params; j++) {
+            svp = av_fetch (row, j, 0);
+            if (svp && SvOK (*svp)) {
+                values[j * num_rows + i] = SvPV_nolen (*svp);
+                null_ind[j * num_rows + i] = 0;
+            } else {
+                values[j * num_rows + i] = NULL;
+                null_ind[j * num_rows + i] = 1;
+            }
+        }
+    }
+
+    if ((res = cci_bind_param_array_size (imp_sth->handle, num_rows)) < 0) {
+        goto ERR_ST_EXECUTE_ARRAY;
+    }
+
+    for (j = 0; j < num_params; j++) {
+        svp = av_fetch (types, j, 0);
+        switch (svp && SvOK (*svp) ? SvIV (*svp) : SQL_UNKNOWN_TYPE) {
+        case SQL_NUMERIC:
+            u_type = CCI_U_TYPE_NUMERIC;
+            break;
+        case SQL_INTEGER:
+            u_type = CCI_U_TYPE_INT;
+            break;
+        case SQL_SMALLINT:
+        case SQL_TINYINT:
+            u_type = CCI_U_TYPE_SHORT;
+            break;
+        case SQL_BIGINT:
+            u_type = CCI_U_TYPE_BIGINT;
+            break;
+        default:
+            u_type = CCI_U_TYPE_CHAR;
+            break;
+        }
+
+        if ((res = cci_bind_param_array (imp_sth->handle,
+                                         j+1,
+                                         CCI_A_TYPE_STR,
+                                         values + j * num_rows,
+                                         null_ind + j * num_rows,
+                                         u_type)) < 0) {
+            goto ERR_ST_EXECUTE_ARRAY;
+        }
+    }
+
+    if ((res = cci_execute_array (imp_sth->handle, &qr, &error)) < 0) {
+        goto ERR_ST_EXECUTE_ARRAY;
+    }
+
+    for (i = 1; i <= res; i++) {
+        if (CCI_QUERY_RESULT_RESULT (qr, i) < 0) {
+            /* reported as cci_execute would report the row on its own */
+            row_error.err_code = CCI_QUERY_RESULT_ERR_NO (qr, i);
+            snprintf (row_error.err_msg, sizeof (row_error.err_msg), "%s",
+                      CCI_QUERY_RESULT_ERR_MSG (qr, i));
+            handle_error (sth, CCI_ER_DBMS, &row_error);
+
+            err_av = newAV ();
+            av_push (err_av, newSVsv (DBIc_ERR (imp_sth)));
+            av_push (err_av, newSVsv (DBIc_ERRSTR (imp_sth)));
+            av_push (tuple_status, newRV_noinc ((SV *) err_av));
+        } else {
+            av_push (tuple_status, newSViv (CCI_QUERY_RESULT_RESULT (qr, i)));
+            rc_total += CCI_QUERY_RESULT_RESULT (qr, i);
+        }
+    }
+    cci_query_result_free (qr, res);
+
+    imp_sth->sql_type = sql_type;
+    imp_sth->col_count = col_count;
+    imp_sth->affected_rows = rc_total;
+
+    _cubrid_unbind_array (imp_sth);
+    Safefree (values);
+    Safefree (null_ind);
+    return sv_2mortal (newSViv (rc_total));
+
+ERR_ST_EXECUTE_ARRAY:
+    _cubrid_unbind_array (imp_sth);
+    Safefree (values);
+    Safefree (null_ind);
+    handle_error (sth, res, &error);
+    return &PL_sv_undef;
+}
+
+/***************************************************************************
+ *
+ * Name:    _cubrid_bind_number
+ *
+ * Purpose: Bind a Perl number as a CCI number, so that it does not go
+ *          through a string on either side. Integer types take an IV,
+ *          floating point types an IV or NV. Without a sql_type only
+ *          integers that never were strings are bound this way, so that
+ *          "007" stays a string and decimals keep their text precision.
+ *
+ * Returns: 1 if the value was bound (res is set to the result of
+ *          cci_bind_param), 0 if it has to be bound as a string
+ *
+ **************************************************************************/
+
+static int
+_cubrid_bind_number( imp_sth_t *imp_sth, int index, SV *value,
+                     IV sql_type, int *res )
+{
+    T_CCI_U_TYPE u_type;
+    long long bi_val;
+    int i_val;
+    double d_val;
+
+    switch (sql_type) {
+    case SQL_FLOAT:
+    case SQL_REAL:
+    case SQL_DOUBLE:
+        if (!SvNIOK (value)) {
+            return 0;
+        }
+        d_val = SvNV (value);
+        *res = cci_bind_param (imp_sth->handle, index, CCI_A_TYPE_DOUBLE,
+                               &d_val, CCI_U_TYPE_DOUBLE, 0);
+        return 1;
+
+    case SQL_INTEGER:
+        u_type = CCI_U_TYPE_INT;
+        break;
+
+    case SQL_SMALLINT:
+    case SQL_TINYINT:
+        u_type = CCI_U_TYPE_SHORT;
+        break;
+
+    case SQL_BIGINT:
+        u_type = CCI_U_TYPE_BIGINT;
+        break;
+
+    case SQL_UNKNOWN_TYPE:
+        if (SvPOK (value)) {
+            return 0;
+        }
+        u_type = CCI_U_TYPE_NULL;   /* INT or BIGINT by value */
+        break;
+
+    default:
+        return 0;
+    }
+
+    if (!SvIOK (value) || (SvIsUV (value) && SvUVX (value) > IV_MAX)) {
+        return 0;
+    }
+
+    bi_val = (long long) SvIV (value);
+    if (u_type == CCI_U_TYPE_BIGINT
+        || (u_type == CCI_U_TYPE_NULL
+            && (bi_val < INT_MIN || bi_val > INT_MAX))) {
+        *res = cci_bind_param (imp_sth->handle, index, CCI_A_TYPE_BIGINT,
+                               &bi_val, CCI_U_TYPE_BIGINT, 0);
+        return 1;
+    }
+
+    if (bi_val < INT_MIN || bi_val > INT_MAX) {
+        return 0;   /* let the server report the overflow */
+    }
+
+    i_val = (int) bi_val;
+    *res = cci_bind_param (imp_sth->handle, index, CCI_A_TYPE_INT, &i_val,
+                           u_type == CCI_U_TYPE_NULL ? CCI_U_TYPE_INT : u_type,
+                           0);
+    return 1;
+}
+
+/***************************************************************************
+ *
+ * Name:    _cubrid_hold_bind_value
+ *
+ * Purpose: Copy the string value of a placeholder into an SV the statement
+ *          keeps per placeholder, so that CCI can bind it by pointer
+ *          (CCI_BIND_PTR) instead of making its own copy. The SV buffer is
+ *          reused by the next bind of the same placeholder.
+ *
+ * Returns: the held string
+ *
+ **************************************************************************/
+
+static char *
+_cubrid_hold_bind_value( imp_sth_t *imp_sth, int index, SV *value,
+                         STRLEN *len )
+{
+    SV **svp;
+    char *str;
+
+    str = SvPV (value, *len);
+
+    if (!imp_sth->bind_values) {
+        imp_sth->bind_values = newAV ();
+    }
+    svp = av_fetch (imp_sth->bind_values, index - 1, 1);
+    sv_setpvn (*svp, str, *len);
+
+    return SvPVX (*svp);
+}
+
+/* Take the statement out of array mode before cubrid_st_execute_array frees
+ * the arrays; the placeholders are bound again by the next execute */
+static void
+_cubrid_unbind_array( imp_sth_t *imp_sth )
+{
+    cci_bind_param_array_size (imp_sth->handle, 0);
+}
+
 /***************************************************************************
  *
  * Name:    dbd_db_quote
@@ -1634,6 +2344,7 @@ _cubrid_lob_bind( SV *sth,
                   int index, 
                   IV sql_type,
                   char *buf, 
+                  STRLEN len,
                   T_CCI_ERROR *error )
 {
     T_CCI_LOB lob;
@@ -1662,7 +2373,7 @@ _cubrid_lob_bind( SV *sth,
                                   lob, 
                                   u_type,
                                   0, 
-                                  strlen(buf), 
+                                  len, 
                                   buf, 
                                   error)) < 0) {
         _cubrid_lob_free (lob, u_type);
@@ -1867,6 +2578,9 @@ _cubrid_fetch_schema( AV *rows_av,
                       T_CCI_ERROR *error )
 {
     int res;
+    T_CUBRID_DECODER *decoder;
+
+    decoder = _cubrid_build_decoder (col_info, col_count);
 
     while (1) {
         AV *copy_row, *fetch_av;
@@ -1877,11 +2591,11 @@ _cubrid_fetch_schema( AV *rows_av,
             break;
         }
         else if (res < 0) {
-            return res;
+            goto ER_CUBRID_FETCH_SCHEMA;
         }
 
         if ((res = cci_fetch (req_handle, error)) < 0) {
-            return res;
+            goto ER_CUBRID_FETCH_SCHEMA;
         }
 
         fetch_av = newAV();
@@ -1893,11 +2607,11 @@ _cubrid_fetch_schema( AV *rows_av,
         if ((res = _cubrid_fetch_row (fetch_av,
                                       req_handle, 
                                       col_count, 
-                                      col_info, 
+                                      decoder, 
                                       error)) < 0) {
 
             av_undef (fetch_av);
-            return res;
+            goto ER_CUBRID_FETCH_SCHEMA;
         }
 
         copy_row = av_make (AvFILL(fetch_av) + 1, AvARRAY(fetch_av));
@@ -1906,65 +2620,239 @@ _cubrid_fetch_schema( AV *rows_av,
         av_undef (fetch_av);
     }
 
+    Safefree (decoder);
     return 0;
+
+ER_CUBRID_FETCH_SCHEMA:
+    Safefree (decoder);
+    return res;
+}
+
+/* Map a DBI RowCacheSize onto the CCI fetch size: a positive value is
+ * a row count, 0 lets CCI size each fetch within the default byte
+ * budget, and a negative value is the byte budget itself */
+static int
+_cubrid_set_row_cache_size( int req_handle, int size )
+{
+    int res;
+
+    if (size > 0) {
+        if ((res = cci_fetch_size_adaptive (req_handle, 0)) < 0) {
+            return res;
+        }
+        return cci_fetch_size (req_handle, size);
+    }
+
+    return cci_fetch_size_adaptive (req_handle, 
+            size < 0 ? -size : CUBRID_DEFAULT_FETCH_BUDGET);
 }
 
 static int
 _cubrid_fetch_row( AV *av, 
                    int req_handle, 
                    int col_count, 
-                   T_CCI_COL_INFO *col_info, 
+                   T_CUBRID_DECODER *decoder, 
                    T_CCI_ERROR *error )
 {
-    int i, res, type, num, ind;
-    char *buf;
-    double ddata;
+    int i, res;
 
     for (i = 0; i < col_count; i++) {
-        SV *sv = AvARRAY(av)[i];
+        if ((res = _cubrid_fetch_value (AvARRAY(av)[i],
+                                        req_handle,
+                                        i+1,
+                                        decoder[i],
+                                        error)) < 0) {
+            return res;
+        }
+    }
 
-        type = CCI_GET_RESULT_INFO_TYPE (col_info, i+1);
-        
-        switch (type) {
+    return 0;
+}
+
+static T_CUBRID_DECODER *
+_cubrid_build_decoder( T_CCI_COL_INFO *col_info, int col_count )
+{
+    int i;
+    T_CUBRID_DECODER *decoder;
+
+    Newx (decoder, col_count, T_CUBRID_DECODER);
+
+    for (i = 0; i < col_count; i++) {
+        switch (CCI_GET_RESULT_INFO_TYPE (col_info, i+1)) {
         case CCI_U_TYPE_INT:
         case CCI_U_TYPE_SHORT:
-            if ((res = cci_get_data (req_handle, 
-                            i+1, CCI_A_TYPE_INT, &num, &ind)) < 0) {
-                return res;
-            }
-
-            if (ind < 0) {
-                (void) SvOK_off (sv);
-            } else {
-                sv_setiv (sv, num);
-            }
+            decoder[i] = CUBRID_DECODE_INT;
+            break;
+        case CCI_U_TYPE_BIGINT:
+#if IVSIZE >= 8
+            decoder[i] = CUBRID_DECODE_BIGINT;
+#else
+            decoder[i] = CUBRID_DECODE_STR;
+#endif
             break;
         case CCI_U_TYPE_FLOAT:
         case CCI_U_TYPE_DOUBLE:
         case CCI_U_TYPE_NUMERIC:
-            if ((res = cci_get_data (req_handle,
-                            i+1, CCI_A_TYPE_DOUBLE, &ddata, &ind)) < 0) {
-                return res;
-            }
-
-            if (ind < 0) {
-                (void) SvOK_off (sv);
-            } else {
-                sv_setnv (sv, ddata);
-            }
+            decoder[i] = CUBRID_DECODE_DOUBLE;
+            break;
+        case CCI_U_TYPE_DATE:
+            decoder[i] = CUBRID_DECODE_DATE;
+            break;
+        case CCI_U_TYPE_TIME:
+            decoder[i] = CUBRID_DECODE_TIME;
+            break;
+        case CCI_U_TYPE_TIMESTAMP:
+            decoder[i] = CUBRID_DECODE_TIMESTAMP;
+            break;
+        case CCI_U_TYPE_DATETIME:
+            decoder[i] = CUBRID_DECODE_DATETIME;
             break;
         default:
-            if ((res = cci_get_data (req_handle,
-                            i+1, CCI_A_TYPE_STR, &buf, &ind)) < 0) {
-                return res;
-            }
-            if (ind < 0) {
-                (void) SvOK_off (sv);
-            } else {
-                sv_setpvn (sv, buf, strlen(buf));
-            }
+            decoder[i] = CUBRID_DECODE_STR;
         }
     }
 
+    return decoder;
+}
+
+static int
+_cubrid_decoder_a_type( T_CUBRID_DECODER decoder )
+{
+    switch (decoder) {
+    case CUBRID_DECODE_INT:
+        return CCI_A_TYPE_INT;
+    case CUBRID_DECODE_BIGINT:
+        return CCI_A_TYPE_BIGINT;
+    case CUBRID_DECODE_DOUBLE:
+        return CCI_A_TYPE_DOUBLE;
+    case CUBRID_DECODE_DATE:
+    case CUBRID_DECODE_TIME:
+    case CUBRID_DECODE_TIMESTAMP:
+    case CUBRID_DECODE_DATETIME:
+        return CCI_A_TYPE_DATE;
+    default:
+        return CCI_A_TYPE_STR;
+    }
+}
+
+/* Set sv from a value read as _cubrid_decoder_a_type (decoder) */
+static void
+_cubrid_set_value( SV *sv, 
+                   T_CUBRID_DECODER decoder, 
+                   void *value, 
+                   int ind )
+{
+    if (ind < 0) {
+        (void) SvOK_off (sv);
+        return;
+    }
+
+    switch (decoder) {
+    case CUBRID_DECODE_INT:
+        sv_setiv (sv, *(int *) value);
+        break;
+    case CUBRID_DECODE_BIGINT:
+        sv_setiv (sv, (IV) *(long long *) value);
+        break;
+    case CUBRID_DECODE_DOUBLE:
+        sv_setnv (sv, *(double *) value);
+        break;
+    case CUBRID_DECODE_DATE:
+    case CUBRID_DECODE_TIME:
+    case CUBRID_DECODE_TIMESTAMP:
+    case CUBRID_DECODE_DATETIME:
+        _cubrid_set_date (sv, (T_CCI_DATE *) value, decoder);
+        break;
+    default:
+        sv_setpvn (sv, *(char **) value, ind);
+    }
+}
+
+static int
+_cubrid_fetch_value( SV *sv, 
+                     int req_handle, 
+                     int col, 
+                     T_CUBRID_DECODER decoder, 
+                     T_CCI_ERROR *error )
+{
+    int res, ind;
+    union {
+        int num;
+        long long bigint;
+        double ddata;
+        T_CCI_DATE date;
+        char *buf;
+    } value;
+
+    if ((res = cci_get_data (req_handle, col, 
+                    _cubrid_decoder_a_type (decoder), &value, &ind)) < 0) {
+        return res;
+    }
+
+    _cubrid_set_value (sv, decoder, &value, ind);
     return 0;
 }
+
+/* cci_fetch_rows callback of cubrid_st_fetchall_columnar */
+static void
+_cubrid_push_column_value( void *arg, 
+                           int col, 
+                           void *value, 
+                           int ind )
+{
+    T_CUBRID_COLUMNS *columns = (T_CUBRID_COLUMNS *) arg;
+    SV *sv = newSV (0);
+
+    av_push (columns->col_avs[col-1], sv);
+    _cubrid_set_value (sv, columns->decoder[col-1], value, ind);
+}
+
+/* Write 'n' as exactly 'width' zero padded digits */
+#define CUBRID_PUT_DIGITS(p, n, width)              \
+    do {                                            \
+        int _w = (width), _n = (n);                 \
+        while (_w-- > 0) {                          \
+            (p)[_w] = '0' + _n % 10;                \
+            _n /= 10;                               \
+        }                                           \
+        (p) += (width);                             \
+    } while (0)
+
+/* Format a temporal value straight into the SV buffer, producing the
+ * same text as the CCI string conversion (ut_date_to_str) */
+static void
+_cubrid_set_date( SV *sv, T_CCI_DATE *date, T_CUBRID_DECODER decoder )
+{
+    char *start, *p;
+
+    (void) SvUPGRADE (sv, SVt_PV);
+    start = p = SvGROW (sv, 24);
+
+    if (decoder != CUBRID_DECODE_TIME) {
+        CUBRID_PUT_DIGITS (p, date->yr, 4);
+        *p++ = '-';
+        CUBRID_PUT_DIGITS (p, date->mon, 2);
+        *p++ = '-';
+        CUBRID_PUT_DIGITS (p, date->day, 2);
+    }
+
+    if (decoder != CUBRID_DECODE_DATE) {
+        if (decoder != CUBRID_DECODE_TIME) {
+            *p++ = ' ';
+        }
+        CUBRID_PUT_DIGITS (p, date->hh, 2);
+        *p++ = ':';
+        CUBRID_PUT_DIGITS (p, date->mm, 2);
+        *p++ = ':';
+        CUBRID_PUT_DIGITS (p, date->ss, 2);
+    }
+
+    if (decoder == CUBRID_DECODE_DATETIME) {
+        *p++ = '.';
+        CUBRID_PUT_DIGITS (p, date->ms, 3);
+    }
+
+    *p = '\0';
+    SvCUR_set (sv, p - start);
+    (void) SvPOK_only (sv);
+}
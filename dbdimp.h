@@ -41,6 +41,13 @@ struct imp_dbh_st {
 	dbih_dbc_t com;		/* MUST be first element in structure	*/
 
         int     handle;
+
+        int     row_cache_size;     /* RowCacheSize, when has_row_cache_size */
+        int     has_row_cache_size;
+        int     read_ahead;         /* cubrid_read_ahead */
+        int     stmt_pool_size;     /* cubrid_stmt_pool_size */
+        T_CCI_DATASOURCE *pool;     /* cubrid_pool the handle is borrowed from */
+        SV      *pool_sv;
 };
 
 
@@ -53,6 +60,19 @@ typedef struct {
     T_CCI_U_TYPE type;
 } T_CUBRID_LOB;
 
+/* How a result column is turned into a perl scalar; chosen once per
+ * column at execute time from the column's CCI type */
+typedef enum {
+    CUBRID_DECODE_STR = 0,
+    CUBRID_DECODE_INT,
+    CUBRID_DECODE_BIGINT,
+    CUBRID_DECODE_DOUBLE,
+    CUBRID_DECODE_DATE,
+    CUBRID_DECODE_TIME,
+    CUBRID_DECODE_TIMESTAMP,
+    CUBRID_DECODE_DATETIME
+} T_CUBRID_DECODER;
+
 struct imp_sth_st {
 	dbih_stc_t com;		/* MUST be first element in structure	*/
 
@@ -63,8 +83,12 @@ struct imp_sth_st {
         int     affected_rows;
         T_CCI_CUBRID_STMT   sql_type;
         T_CCI_COL_INFO      *col_info;
+        T_CUBRID_DECODER    *decoder;
         T_CUBRID_LOB        *lob;
         int     col_selected;  /* used for lob_get, lob_export */
+        int     row_cache_size;
+        int     has_row_cache_size;
+        AV      *bind_values;   /* strings bound by pointer, see dbd_bind_ph */
 };
 
 /* ------ define functions and external variables ------ */
@@ -105,4 +129,11 @@ int cubrid_st_lob_export (SV *sth, int index, char *file);
 int cubrid_st_lob_import (SV *sth, int index, char *filename, IV sql_type);
 int cubrid_st_lob_close (SV *sth);
 
+SV * cubrid_st_fetchall_columnar (SV *sth, int max_rows);
+SV * cubrid_st_execute_array (SV *sth, AV *rows, AV *types, AV *tuple_status);
+
+SV * cubrid_pool_create (SV *drh, char *url, char *uid, char *pwd, HV *props);
+void cubrid_pool_destroy (IV handle);
+SV * cubrid_pool_stats (IV handle);
+
 /* end */
@@ -0,0 +1,57 @@
+#!perl -w
+
+use strict;
+use DBI qw(:sql_types);
+use Test::More;
+use vars qw($table $test_dsn $test_user $test_passwd);
+use lib 't', '.';
+require 'lib.pl';
+
+my ($dbh, $sth, $row);
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_passwd,
+                      { RaiseError => 1, PrintError => 0, AutoCommit => 1 });};
+if ($@ || !$dbh) {
+    plan skip_all =>
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 22;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table");
+ok $dbh->do("CREATE TABLE $table (id INT, big BIGINT, d DOUBLE, name VARCHAR(64))");
+
+ok $sth = $dbh->prepare("INSERT INTO $table VALUES (?, ?, ?, ?)");
+
+# numbers bound as numbers
+ok $sth->bind_param(1, 1, SQL_INTEGER);
+ok $sth->bind_param(2, 5000000000, SQL_BIGINT);
+ok $sth->bind_param(3, 2.5, SQL_DOUBLE);
+ok $sth->bind_param(4, 7);
+ok $sth->execute;
+
+# strings bound from temporaries outlive the bind_param call
+ok $sth->bind_param(1, 2, SQL_INTEGER);
+{
+    my $name = "tmp";
+    ok $sth->bind_param(4, $name . "-" . 2);
+}
+ok $sth->execute;
+
+ok $sth->execute(3, 6000000000, "3.25", "007");
+
+ok $row = $dbh->selectall_arrayref("SELECT id, big, d, name FROM $table ORDER BY id");
+is_deeply [map { $_->[0] } @$row], [1, 2, 3], 'ids';
+is_deeply [map { $_->[1] } @$row], [5000000000, 5000000000, 6000000000], 'bigints';
+is_deeply [map { $_->[2] + 0 } @$row], [2.5, 2.5, 3.25], 'doubles';
+is_deeply [map { $_->[3] } @$row], ['7', 'tmp-2', '007'], 'strings';
+
+# strings are bound and fetched by length, so NULs survive
+ok $sth->execute(4, 0, 0, "a\0b");
+is $dbh->selectrow_array("SELECT name FROM $table WHERE id = 4"), "a\0b",
+    'embedded NUL';
+
+# a typed bind of a non-number is still refused
+eval { $sth->bind_param(1, 'abc', SQL_INTEGER) };
+ok $@, 'non-number refused for SQL_INTEGER';
+
+ok $dbh->do("DROP TABLE $table");
+ok $dbh->disconnect;
@@ -0,0 +1,54 @@
+#!perl -w
+
+use strict;
+use DBI;
+use Test::More;
+use vars qw($table $test_dsn $test_user $test_passwd);
+use lib 't', '.';
+require 'lib.pl';
+
+my ($dbh, $sth, $cols);
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_passwd,
+                      { RaiseError => 1, PrintError => 1, AutoCommit => 0 });};
+if ($@) {
+    plan skip_all => 
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 16;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table");
+
+my $create= <<EOT;
+CREATE TABLE $table (
+  id INT(4) NOT NULL DEFAULT 0,
+  name varchar(64)
+) 
+EOT
+
+ok $dbh->do($create), "CREATE TABLE $table";
+
+$sth = $dbh->prepare("INSERT INTO $table VALUES(?, ?)");
+for my $i (1 .. 250) {
+    $sth->execute($i, $i % 10 ? "name$i" : undef);
+}
+ok $dbh->commit, "inserted 250 rows";
+
+ok ($sth = $dbh->prepare("SELECT id, name FROM $table ORDER BY id"));
+ok $sth->execute;
+
+ok ($cols = $sth->cubrid_fetchall_columnar);
+is scalar @$cols, 2, 'one array per column';
+is scalar @{$cols->[0]}, 250, 'all rows fetched';
+is $cols->[0][249], 250, 'last id';
+is $cols->[1][0], 'name1', 'string column';
+ok !defined($cols->[1][9]), 'NULL fetched as undef';
+
+ok $sth->execute;
+$cols = $sth->cubrid_fetchall_columnar(100);
+is scalar @{$cols->[0]}, 100, 'max_rows honoured';
+$cols = $sth->cubrid_fetchall_columnar;
+is $cols->[0][0], 101, 'next call continues after the previous chunk';
+is scalar @{$cols->[0]}, 150, 'remaining rows fetched';
+
+ok $dbh->do("DROP TABLE $table"), "Drop table $table";
+$dbh->disconnect;
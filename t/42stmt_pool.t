@@ -0,0 +1,59 @@
+#!perl -w
+
+use strict;
+use DBI;
+use Test::More;
+use vars qw($table $test_dsn $test_user $test_passwd);
+use lib 't', '.';
+require 'lib.pl';
+
+my ($dbh, $sth, $row);
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_passwd,
+                      { RaiseError => 1, PrintError => 1, AutoCommit => 1,
+                        cubrid_stmt_pool_size => 2 });};
+if ($@) {
+    plan skip_all => 
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 12;
+
+is $dbh->{cubrid_stmt_pool_size}, 2, 'pool size set at connect';
+
+ok $dbh->do("DROP TABLE IF EXISTS $table");
+ok $dbh->do("CREATE TABLE $table (id INT, name VARCHAR(64))"), "CREATE TABLE $table";
+
+$sth = $dbh->prepare("INSERT INTO $table VALUES(?, ?)");
+$sth->execute($_, "name$_") for 1 .. 10;
+undef $sth;
+
+for my $id (3, 7) {
+    $sth = $dbh->prepare("SELECT name FROM $table WHERE id = ?");
+    ok $sth->execute($id), "execute pooled statement for id $id";
+    $row = $sth->fetchrow_arrayref;
+    is $row->[0], "name$id", 'pooled statement returns its own result';
+    undef $sth;
+}
+
+# a statement taken from the pool starts out unbound
+$sth = $dbh->prepare("SELECT name FROM $table WHERE id = ?");
+$row = eval { $sth->execute; $sth->fetchrow_arrayref };
+ok !($row && defined $row->[0]), 'pooled statement does not keep old binds';
+undef $sth;
+
+# push the SELECT out of the pool and prepare it again
+$dbh->prepare("SELECT id FROM $table WHERE id = 1")->execute;
+$dbh->prepare("SELECT id FROM $table WHERE id = 2")->execute;
+$sth = $dbh->prepare("SELECT name FROM $table WHERE id = ?");
+$sth->execute(9);
+is $sth->fetchrow_arrayref->[0], 'name9', 'statement prepared again after eviction';
+undef $sth;
+
+$dbh->{cubrid_stmt_pool_size} = 0;
+is $dbh->{cubrid_stmt_pool_size}, 0, 'pool turned off';
+$sth = $dbh->prepare("SELECT count(*) FROM $table");
+$sth->execute;
+is $sth->fetchrow_arrayref->[0], 10, 'prepare works without the pool';
+undef $sth;
+
+ok $dbh->do("DROP TABLE $table"), "Drop table $table";
+$dbh->disconnect;
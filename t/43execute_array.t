@@ -0,0 +1,53 @@
+#!perl -w
+
+use strict;
+use DBI;
+use Test::More;
+use vars qw($table $test_dsn $test_user $test_passwd);
+use lib 't', '.';
+require 'lib.pl';
+
+my ($dbh, $sth, @status, $rc);
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_passwd,
+                      { RaiseError => 0, PrintError => 0, AutoCommit => 1 });};
+if ($@ || !$dbh) {
+    plan skip_all => 
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 15;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table");
+ok $dbh->do("CREATE TABLE $table (id INT PRIMARY KEY, name VARCHAR(64))"),
+    "CREATE TABLE $table";
+
+ok ($sth = $dbh->prepare("INSERT INTO $table VALUES(?, ?)"));
+
+my @ids = (1 .. 2500);
+my @names = map { $_ % 10 ? "name$_" : undef } @ids;
+$rc = $sth->execute_array({ ArrayTupleStatus => \@status }, \@ids, \@names);
+is $rc, 2500, 'all tuples executed';
+is scalar @status, 2500, 'one status per tuple';
+is $status[0], 1, 'status holds the affected row count';
+
+my ($count) = $dbh->selectrow_array("SELECT count(*) FROM $table");
+is $count, 2500, 'rows inserted across several batches';
+my ($nulls) = $dbh->selectrow_array("SELECT count(*) FROM $table WHERE name IS NULL");
+is $nulls, 250, 'undef inserted as NULL';
+
+# the second tuple violates the primary key
+@status = ();
+$rc = $sth->execute_array({ ArrayTupleStatus => \@status },
+                          [ 3000, 1, 3001 ], [ 'a', 'b', 'c' ]);
+ok !defined $rc, 'execute_array reports the failed tuple';
+is ref $status[1], 'ARRAY', 'failed tuple has an error entry';
+is scalar @{$status[1]}, 3, 'error entry holds err, errstr and state';
+like $status[1][1], qr/CUBRID DBMS Error/, 'errstr formatted as for execute';
+is $status[2], 1, 'later tuples still executed';
+
+$sth = $dbh->prepare("UPDATE $table SET name = ? WHERE id = ?");
+$sth->bind_param_array(1, 'updated');
+$sth->bind_param_array(2, [ 1, 2, 3 ]);
+ok $sth->execute_array({ ArrayTupleStatus => \@status }), 'bind_param_array rows';
+
+ok $dbh->do("DROP TABLE $table"), "Drop table $table";
+$dbh->disconnect;
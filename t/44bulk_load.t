@@ -0,0 +1,70 @@
+#!perl -w
+
+use strict;
+use DBI;
+use Test::More;
+use vars qw($table $test_dsn $test_user $test_passwd);
+use lib 't', '.';
+require 'lib.pl';
+
+my ($dbh, $stats);
+eval {$dbh= DBI->connect($test_dsn, $test_user, $test_passwd,
+                      { RaiseError => 1, PrintError => 1, AutoCommit => 1 });};
+if ($@) {
+    plan skip_all => 
+        "ERROR: $DBI::errstr. Can't continue test";
+}
+plan tests => 18;
+
+ok $dbh->do("DROP TABLE IF EXISTS $table");
+ok $dbh->do("CREATE TABLE $table (id INT, name VARCHAR(64))"), "CREATE TABLE $table";
+
+my $i = 0;
+my @chunks;
+$stats = $dbh->cubrid_bulk_load ($table, [qw(id name)],
+                                 sub { $i < 5000 ? [ ++$i, "name$i" ] : undef },
+                                 chunk_bytes => 16384, commit_every => 2,
+                                 on_chunk => sub { push @chunks, $_[1] });
+ok $stats, 'bulk load from an iterator';
+is $stats->{rows}, 5000, 'all rows loaded';
+ok $stats->{chunks} > 1, 'rows split into chunks';
+is scalar @chunks, $stats->{chunks}, 'on_chunk called once per chunk';
+ok $dbh->{AutoCommit}, 'AutoCommit restored';
+
+my $data = join '', map { "$_\t" . ($_ % 2 ? "odd" : '\N') . "\n" } 1 .. 10;
+open my $fh, '<', \$data or die $!;
+$dbh->do("DELETE FROM $table");
+$stats = $dbh->cubrid_bulk_load ($table, [qw(id name)], $fh);
+is $stats->{rows}, 10, 'bulk load from a filehandle';
+my ($nulls) = $dbh->selectrow_array("SELECT count(*) FROM $table WHERE name IS NULL");
+is $nulls, 5, '\N loaded as NULL';
+is $stats->{errors}, 0, 'no rejected rows';
+
+# a failed chunk is rolled back and AutoCommit is still restored
+$dbh->do("DELETE FROM $table");
+$i = 0;
+$stats = eval {
+    $dbh->cubrid_bulk_load ($table, [qw(id name)],
+                            sub { $i++ < 3000 ? [ $i, "name$i" ] : [ $i ] },
+                            chunk_bytes => 16384, commit_every => 0);
+};
+ok !$stats && $@, 'failed chunk raises the error';
+ok $dbh->{AutoCommit}, 'AutoCommit restored after the error';
+ok $dbh->{RaiseError}, 'RaiseError restored after the error';
+my ($count) = $dbh->selectrow_array("SELECT count(*) FROM $table");
+is $count, 0, 'loaded rows rolled back';
+
+# a reserved word as column name; the duplicate key is rejected, not loaded
+my $kw_table = "${table}_kw";
+$dbh->do("DROP TABLE IF EXISTS $kw_table");
+ok $dbh->do(qq{CREATE TABLE $kw_table ("order" INT PRIMARY KEY)}),
+    "CREATE TABLE $kw_table";
+my @keys = (1, 2, 2);
+$stats = $dbh->cubrid_bulk_load ($kw_table, [qw(order)],
+                                 sub { @keys ? [ shift @keys ] : undef });
+is_deeply [ @$stats{qw(rows errors)} ], [ 2, 1 ],
+    'rejected rows are not counted as loaded';
+ok $dbh->do("DROP TABLE $kw_table"), "Drop table $kw_table";
+
+ok $dbh->do("DROP TABLE $table"), "Drop table $table";
+$dbh->disconnect;
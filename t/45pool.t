@@ -0,0 +1,51 @@
+#!perl -w
+
+use strict;
+use DBI;
+use DBD::cubrid;
+use Test::More;
+use vars qw($test_dsn $test_user $test_passwd);
+use lib 't', '.';
+require 'lib.pl';
+
+my ($pool, $dbh, $stats);
+eval {$pool = DBD::cubrid->create_pool($test_dsn, $test_user, $test_passwd,
+                                       { pool_size => 1, max_wait => 200 });};
+if ($@) {
+    plan skip_all => 
+        "ERROR: $@. Can't continue test";
+}
+plan tests => 12;
+
+$dbh = DBI->connect($test_dsn, $test_user, $test_passwd,
+                    { RaiseError => 1, PrintError => 0, cubrid_pool => $pool });
+ok $dbh, 'connect with cubrid_pool';
+is $dbh->{cubrid_pool}, $pool, 'cubrid_pool attribute';
+my ($one) = $dbh->selectrow_array("SELECT 1 FROM db_root");
+is $one, 1, 'query on a pooled connection';
+
+my $busy = DBI->connect($test_dsn, $test_user, $test_passwd,
+                        { RaiseError => 0, PrintError => 0, cubrid_pool => $pool });
+ok !$busy, 'connect fails when the pool is exhausted';
+ok $dbh->disconnect, 'disconnect gives the connection back';
+
+$dbh = DBI->connect($test_dsn, $test_user, $test_passwd,
+                    { RaiseError => 1, PrintError => 0, cubrid_pool => $pool });
+ok $dbh->ping, 'borrow again';
+$dbh->disconnect;
+
+$stats = $pool->stats;
+is $stats->{borrows}, 2, 'borrows counted';
+is $stats->{timeouts}, 1, 'timeouts counted';
+is $stats->{open}, 1, 'connection reused';
+
+my $dbh1 = DBI->connect($test_dsn, $test_user, $test_passwd,
+                        { RaiseError => 1, PrintError => 0, cubrid_pool => { pool_size => 1 } });
+my $pool1 = $dbh1->{cubrid_pool};
+$dbh1->disconnect;
+ok $pool1, 'implicit pool';
+$dbh1 = DBI->connect($test_dsn, $test_user, $test_passwd,
+                     { RaiseError => 1, PrintError => 0, cubrid_pool => { pool_size => 1 } });
+is $dbh1->{cubrid_pool}, $pool1, 'implicit pool shared by connects';
+is $pool1->stats->{open}, 1, 'implicit pool reuses its connection';
+$dbh1->disconnect;